@@ -0,0 +1,297 @@
+"""Python bindings for libattractor (see libattractor.h).
+
+    import attractor
+    attractor.load_config("examples/attractor_config.example")
+    with attractor.Context(width=640, height=360, num_particles=200000, seed=1) as ctx:
+        for _ in range(120):
+            ctx.step()
+            frame = ctx.render()        # (360, 640, 3) uint8, a view of the engine's frame
+        ctx.sync()
+        print(ctx.x[:4], ctx.speed.max())
+
+The particle, accum and frame arrays are zero-copy NumPy views of the
+engine's host buffers, created once per context. They are refreshed in place:
+the frame by render(), the rest by sync(). Edits to the particle arrays go back
+to the engine with push(). After close() the arrays stay readable with their
+last contents; the engine memory behind them is freed once they are all gone.
+
+step() and render() run through ctypes, which releases the GIL for the
+duration of the native call, so separate Contexts can run on separate threads
+at once. One Context must be driven by one thread at a time (command()
+excepted). Config is process-wide: do not call load_config(), configure() or
+reload_config() while another thread is driving a context.
+
+The shared library is found via $LIBATTRACTOR, next to this file, or on the
+system library path.
+"""
+
+import ctypes
+import ctypes.util
+import os
+
+import numpy as np
+
+MODES = ("flow", "map", "ifs", "bifurcation")
+
+
+class _Options(ctypes.Structure):
+    _fields_ = [
+        ("mode", ctypes.c_int),
+        ("num_particles", ctypes.c_int),
+        ("width", ctypes.c_int),
+        ("height", ctypes.c_int),
+        ("start_type", ctypes.c_int),
+        ("frames_per_fragment", ctypes.c_int),
+        ("seed", ctypes.c_uint),
+        ("chapter_log", ctypes.c_char_p),
+        ("volume_prefix", ctypes.c_char_p),
+        ("ply_prefix", ctypes.c_char_p),
+        ("proxy", ctypes.c_int),
+        ("physics_interval", ctypes.c_int),
+        ("temporal_frames", ctypes.c_int),
+    ]
+
+
+class _Stats(ctypes.Structure):
+    _fields_ = [
+        ("frame", ctypes.c_int),
+        ("current_type", ctypes.c_int),
+        ("previous_type", ctypes.c_int),
+        ("transition_blend", ctypes.c_float),
+        ("cam_scale", ctypes.c_float),
+        ("cam_cx", ctypes.c_float),
+        ("cam_cy", ctypes.c_float),
+        ("noise_metric", ctypes.c_int),
+        ("noise", ctypes.c_float),
+        ("mean_noise", ctypes.c_double),
+        ("frames_rendered", ctypes.c_int),
+        ("num_particles", ctypes.c_int),
+        ("width", ctypes.c_int),
+        ("height", ctypes.c_int),
+        ("volumes_written", ctypes.c_int),
+        ("clouds_written", ctypes.c_int),
+    ]
+
+
+_float_p = ctypes.POINTER(ctypes.c_float)
+
+
+class _Buffers(ctypes.Structure):
+    _fields_ = [
+        ("x", _float_p), ("y", _float_p), ("z", _float_p),
+        ("vx", _float_p), ("vy", _float_p), ("vz", _float_p),
+        ("speed", _float_p),
+        ("accum", _float_p),
+        ("frame", ctypes.POINTER(ctypes.c_ubyte)),
+        ("num_particles", ctypes.c_int),
+        ("width", ctypes.c_int),
+        ("height", ctypes.c_int),
+        ("accum_width", ctypes.c_int),
+        ("accum_height", ctypes.c_int),
+    ]
+
+
+def _load_library():
+    candidates = [os.environ.get("LIBATTRACTOR"),
+                  os.path.join(os.path.dirname(os.path.abspath(__file__)), "libattractor.so"),
+                  ctypes.util.find_library("attractor")]
+    for path in candidates:
+        if path and (os.path.exists(path) or not os.path.dirname(path)):
+            return ctypes.CDLL(path)
+    raise OSError("libattractor.so not found; build it or set LIBATTRACTOR")
+
+
+_lib = _load_library()
+_ctx_p = ctypes.c_void_p
+
+_lib.ac_default_options.argtypes = [ctypes.POINTER(_Options)]
+_lib.ac_default_options.restype = None
+_lib.ac_mode_from_name.argtypes = [ctypes.c_char_p]
+_lib.ac_mode_from_name.restype = ctypes.c_int
+_lib.ac_load_config.argtypes = [ctypes.c_char_p]
+_lib.ac_load_config.restype = None
+_lib.ac_configure.argtypes = [ctypes.c_char_p, ctypes.c_char_p]
+_lib.ac_configure.restype = ctypes.c_int
+_lib.ac_reload_config.argtypes = [_ctx_p, ctypes.c_char_p]
+_lib.ac_reload_config.restype = ctypes.c_int
+_lib.ac_create.argtypes = [ctypes.POINTER(_Options)]
+_lib.ac_create.restype = _ctx_p
+_lib.ac_destroy.argtypes = [_ctx_p]
+_lib.ac_destroy.restype = None
+_lib.ac_step.argtypes = [_ctx_p]
+_lib.ac_step.restype = None
+_lib.ac_render.argtypes = [_ctx_p, ctypes.c_void_p]
+_lib.ac_render.restype = None
+_lib.ac_get_stats.argtypes = [_ctx_p, ctypes.POINTER(_Stats)]
+_lib.ac_get_stats.restype = None
+_lib.ac_get_buffers.argtypes = [_ctx_p, ctypes.POINTER(_Buffers)]
+_lib.ac_get_buffers.restype = None
+_lib.ac_sync_host.argtypes = [_ctx_p]
+_lib.ac_sync_host.restype = None
+_lib.ac_sync_device.argtypes = [_ctx_p]
+_lib.ac_sync_device.restype = None
+_lib.ac_request_point_cloud.argtypes = [_ctx_p]
+_lib.ac_request_point_cloud.restype = None
+_lib.ac_flush.argtypes = [_ctx_p]
+_lib.ac_flush.restype = None
+_lib.ac_post_command.argtypes = [_ctx_p, ctypes.c_char_p]
+_lib.ac_post_command.restype = ctypes.c_int
+
+
+def _encode(s):
+    return s.encode() if s is not None else None
+
+
+def load_config(path):
+    """Apply a config file (process-wide; read by contexts created afterwards)."""
+    _lib.ac_load_config(_encode(os.fspath(path)))
+
+
+def configure(key, value):
+    """Set one config key (process-wide); raises KeyError for unknown keys."""
+    if _lib.ac_configure(_encode(key), _encode(str(value))) != 0:
+        raise KeyError(key)
+
+
+class _Handle:
+    """Owns the native context. The array views hold this rather than the
+    Context, so the engine memory outlives close() while any view is alive and
+    no reference cycle forms."""
+
+    def __init__(self, ptr):
+        self.ptr = ptr
+
+    def __del__(self):
+        if self.ptr:
+            _lib.ac_destroy(self.ptr)
+            self.ptr = None
+
+
+class Context:
+    """One engine instance: particles, camera, schedule and render buffers."""
+
+    _ARRAYS = ("x", "y", "z", "vx", "vy", "vz", "speed", "accum", "frame")
+
+    def __init__(self, mode="flow", num_particles=None, width=None, height=None, start_type=None,
+                 frames_per_fragment=None, seed=0, chapter_log=None, volume_prefix=None, ply_prefix=None,
+                 proxy=False, physics_interval=None, temporal_frames=None):
+        opt = _Options()
+        _lib.ac_default_options(ctypes.byref(opt))
+        opt.mode = _lib.ac_mode_from_name(_encode(mode))
+        if opt.mode < 0 or mode not in MODES:
+            raise ValueError("mode must be one of %s" % (MODES,))
+        for name, value in (("num_particles", num_particles), ("width", width), ("height", height),
+                            ("start_type", start_type), ("frames_per_fragment", frames_per_fragment),
+                            ("physics_interval", physics_interval), ("temporal_frames", temporal_frames)):
+            if value is not None:
+                setattr(opt, name, int(value))
+        opt.seed = seed
+        opt.chapter_log = _encode(chapter_log)
+        opt.volume_prefix = _encode(volume_prefix)
+        opt.ply_prefix = _encode(ply_prefix)
+        opt.proxy = int(bool(proxy))
+        self._ctx = _lib.ac_create(ctypes.byref(opt))
+        if not self._ctx:
+            raise RuntimeError("ac_create failed (see stderr)")
+        self._handle = _Handle(self._ctx)
+
+        buf = _Buffers()
+        _lib.ac_get_buffers(self._ctx, ctypes.byref(buf))
+        n, w, h = buf.num_particles, buf.width, buf.height
+        self.num_particles, self.width, self.height = n, w, h
+        self.x, self.y, self.z = (self._view(buf.x, ctypes.c_float, (n,)),
+                                  self._view(buf.y, ctypes.c_float, (n,)),
+                                  self._view(buf.z, ctypes.c_float, (n,)))
+        self.vx, self.vy, self.vz = (self._view(buf.vx, ctypes.c_float, (n,)),
+                                     self._view(buf.vy, ctypes.c_float, (n,)),
+                                     self._view(buf.vz, ctypes.c_float, (n,)))
+        self.speed = self._view(buf.speed, ctypes.c_float, (n,))
+        self.accum = self._view(buf.accum, ctypes.c_float, (buf.accum_height, buf.accum_width, 3))
+        self.frame = self._view(buf.frame, ctypes.c_ubyte, (h, w, 3))
+
+    def _view(self, ptr, ctype, shape):
+        if not ptr:
+            return None
+        count = int(np.prod(shape))
+        raw = (ctype * count).from_address(ctypes.addressof(ptr.contents))
+        raw._owner = self._handle  # Keep the engine memory alive while any view is
+        return np.frombuffer(raw, dtype=np.dtype(ctype)).reshape(shape)
+
+    def _check(self):
+        if not self._ctx:
+            raise ValueError("context is closed")
+
+    def step(self, frames=1):
+        """Advance schedule, physics and camera by `frames` frames."""
+        self._check()
+        for _ in range(frames):
+            _lib.ac_step(self._ctx)
+
+    def render(self, out=None):
+        """Render and tone map; returns the frame view, or copies into `out`."""
+        self._check()
+        if out is not None:
+            if out.shape != self.frame.shape or out.dtype != np.uint8 or not out.flags.c_contiguous:
+                raise ValueError("out must be a C-contiguous uint8 array of shape %s" % (self.frame.shape,))
+            _lib.ac_render(self._ctx, out.ctypes.data)
+            return out
+        _lib.ac_render(self._ctx, None)
+        return self.frame
+
+    def sync(self):
+        """Refresh x/y/z, vx/vy/vz, speed and accum from the engine."""
+        self._check()
+        _lib.ac_sync_host(self._ctx)
+
+    def push(self):
+        """Send edits to x/y/z and vx/vy/vz back to the engine."""
+        self._check()
+        _lib.ac_sync_device(self._ctx)
+
+    def stats(self):
+        self._check()
+        st = _Stats()
+        _lib.ac_get_stats(self._ctx, ctypes.byref(st))
+        return {name: getattr(st, name) for name, _ in _Stats._fields_}
+
+    def request_point_cloud(self):
+        self._check()
+        _lib.ac_request_point_cloud(self._ctx)
+
+    def reload_config(self, path):
+        """Re-apply the live keys of a config file now; returns how many changed."""
+        self._check()
+        changed = _lib.ac_reload_config(self._ctx, _encode(os.fspath(path)))
+        if changed < 0:
+            raise OSError("could not read %s" % path)
+        return changed
+
+    def command(self, line):
+        """Queue a live control command (see ac_post_command) for the next step.
+
+        May be called from another thread while this one steps; raises
+        BlockingIOError if the command queue is full.
+        """
+        self._check()
+        if _lib.ac_post_command(self._ctx, _encode(line)) != 0:
+            raise BlockingIOError("command queue full")
+
+    def flush(self):
+        self._check()
+        _lib.ac_flush(self._ctx)
+
+    def close(self):
+        """Flush pending exports and release the context. Arrays taken from it
+        keep their last contents; its memory is freed when the last one goes."""
+        if self._ctx:
+            _lib.ac_flush(self._ctx)
+            self._ctx = None
+            self._handle = None
+            for name in self._ARRAYS:
+                setattr(self, name, None)
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
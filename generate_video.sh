@@ -11,6 +11,12 @@ FRAMERATE=60
 PARTICLES=2000000
 CONFIG_FILE=""
 START_TYPE=""
+MODE=""
+RESOLUTION="1920x1080"
+SEED=""
+PROXY=0
+CONTROL=""
+WATCH=0
 
 # Parse command line arguments
 while [[ $# -gt 0 ]]; do
@@ -51,6 +57,30 @@ while [[ $# -gt 0 ]]; do
             START_TYPE="$2"
             shift 2
             ;;
+        -m|--mode)
+            MODE="$2"
+            shift 2
+            ;;
+        -r|--resolution)
+            RESOLUTION="$2"
+            shift 2
+            ;;
+        --seed)
+            SEED="$2"
+            shift 2
+            ;;
+        --proxy)
+            PROXY=1
+            shift
+            ;;
+        --control)
+            CONTROL="$2"
+            shift 2
+            ;;
+        -w|--watch)
+            WATCH=1
+            shift
+            ;;
         -h|--help)
             echo "Usage: $0 [options]"
             echo ""
@@ -59,7 +89,18 @@ while [[ $# -gt 0 ]]; do
             echo "  -f, --frames N            Frames per fragment (default: 300)"
             echo "  -p, --particles N         Number of particles (default: 2000000)"
             echo "  -c, --config FILE         Config file for zoom parameters (optional)"
-            echo "  -s, --start-type N        Starting attractor: 0=Aizawa 1=Thomas 2=Lorenz 3=Halvorsen 4=Chen"
+            echo "  -s, --start-type N        Starting attractor: 0=Aizawa 1=Thomas 2=Lorenz 3=Halvorsen 4=Chen 5=HyperLorenz 6=HyperRossler"
+            echo "  -m, --mode MODE           Run mode: flow (default), map, ifs, bifurcation"
+            echo "                            (lyapunov writes a still PPM; run the binary directly)"
+            echo "                            (calibrate writes framing config lines; run the binary directly)"
+            echo "                            (still writes a long-exposure PPM or, with -t, a tiled TIFF; run the binary directly)"
+            echo "  -r, --resolution WxH      Output resolution (default: 1920x1080)"
+            echo "  --seed N                  Seed placement and parameter choices (repeatable runs)"
+            echo "  --proxy                   Fast preview: 1/20 of the particles, half-size render upscaled"
+            echo "                            (same --seed as the final render gives the same cuts)"
+            echo "  --control SOCKET          Accept live commands on a UNIX socket (see README)"
+            echo "  -w, --watch               Re-apply live keys when the config file changes (needs -c)"
+            echo "                            (with either, the engine's stderr log stays on the terminal)"
             echo "  -o, --output FILE         Output filename (default: cinematic.mp4)"
             echo "  --crf N                   Video quality 0-51, lower=better (default: 18)"
             echo "  --preset PRESET           Encoding preset: ultrafast, fast, medium, slow (default: fast)"
@@ -92,6 +133,7 @@ echo "Fragments:        $FRAGMENTS"
 echo "Frames/fragment:  $FRAMES_PER_FRAGMENT"
 echo "Particles:        $PARTICLES"
 echo "Total frames:     $TOTAL_FRAMES"
+echo "Resolution:       $RESOLUTION"
 echo "Frame rate:       ${FRAMERATE} fps"
 echo "Duration:         ${DURATION} seconds"
 echo "Output:           $OUTPUT"
@@ -100,8 +142,15 @@ echo "Preset:           $PRESET"
 if [ -n "$CONFIG_FILE" ]; then
     echo "Config file:      $CONFIG_FILE"
 fi
+if [ -n "$MODE" ]; then
+    echo "Mode:             $MODE"
+fi
 if [ -n "$START_TYPE" ]; then
-    ATTRACTOR_NAMES=("Aizawa" "Thomas" "Lorenz" "Halvorsen" "Chen")
+    if [ "$MODE" = "map" ]; then
+        ATTRACTOR_NAMES=("Clifford" "De Jong" "Henon" "Svensson")
+    else
+        ATTRACTOR_NAMES=("Aizawa" "Thomas" "Lorenz" "Halvorsen" "Chen" "HyperLorenz" "HyperRossler")
+    fi
     echo "Start attractor:  ${ATTRACTOR_NAMES[$START_TYPE]} (type $START_TYPE)"
 fi
 echo "======================================"
@@ -110,7 +159,7 @@ echo ""
 # Check if attractor_cinematic exists
 if [ ! -f "./attractor_cinematic" ]; then
     echo "Error: attractor_cinematic binary not found"
-    echo "Run: nvc -acc -fast -Minfo=accel -o attractor_cinematic attractor_cinematic.c -lm"
+    echo "Run: nvc -acc -fast -Minfo=accel -o attractor_cinematic attractor_cinematic.c libattractor.c -lm -lpthread"
     exit 1
 fi
 
@@ -125,16 +174,38 @@ echo "Generating video..."
 echo ""
 
 # Build attractor command with optional config and start type
-ATTRACTOR_CMD="./attractor_cinematic -n $FRAGMENTS -f $FRAMES_PER_FRAGMENT -p $PARTICLES"
+ATTRACTOR_CMD="./attractor_cinematic -n $FRAGMENTS -f $FRAMES_PER_FRAGMENT -p $PARTICLES -r $RESOLUTION"
 if [ -n "$CONFIG_FILE" ]; then
     ATTRACTOR_CMD="$ATTRACTOR_CMD -c $CONFIG_FILE"
 fi
 if [ -n "$START_TYPE" ]; then
     ATTRACTOR_CMD="$ATTRACTOR_CMD -s $START_TYPE"
 fi
+if [ -n "$MODE" ]; then
+    ATTRACTOR_CMD="$ATTRACTOR_CMD -m $MODE"
+fi
+if [ -n "$SEED" ]; then
+    ATTRACTOR_CMD="$ATTRACTOR_CMD -S $SEED"
+fi
+if [ "$PROXY" = 1 ]; then
+    ATTRACTOR_CMD="$ATTRACTOR_CMD -P"
+fi
+if [ -n "$CONTROL" ]; then
+    ATTRACTOR_CMD="$ATTRACTOR_CMD -C $CONTROL"
+fi
+if [ "$WATCH" = 1 ]; then
+    ATTRACTOR_CMD="$ATTRACTOR_CMD -w"
+fi
+
+# Live control and config watching report what they apply on stderr, so
+# keep it on the terminal for those; otherwise only ffmpeg progress is shown
+ENGINE_STDERR=/dev/null
+if [ -n "$CONTROL" ] || [ "$WATCH" = 1 ]; then
+    ENGINE_STDERR=/dev/stderr
+fi
 
-$ATTRACTOR_CMD 2>/dev/null | \
-    ffmpeg -f rawvideo -pixel_format rgb24 -video_size 1920x1080 \
+$ATTRACTOR_CMD 2>"$ENGINE_STDERR" | \
+    ffmpeg -f rawvideo -pixel_format rgb24 -video_size "$RESOLUTION" \
     -framerate "$FRAMERATE" -i - \
     -c:v libx264 -preset "$PRESET" -crf "$CRF" \
     -g 300 -keyint_min 60 \
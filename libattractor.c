@@ -0,0 +1,4270 @@
+#define _FILE_OFFSET_BITS 64                // Tiled stills can pass 4 GB
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <float.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <openacc.h>
+#include "libattractor.h"
+
+// --- Configuration ---
+#define WIDTH 1920                          // Default output size (-r WxH overrides)
+#define HEIGHT 1080
+#define NUM_PARTICLES 2000000
+#define DT 0.012f  
+#define EXPOSURE 2.5f 
+#define STATS_STRIDE 100                    // Every n-th particle feeds the camera statistics
+#define PROXY_STRIDE 20                     // Proxy keeps one particle in n (divides STATS_STRIDE,
+                                            // so the camera sees the same particles as a full render)
+#define PROXY_SCALE 2                       // Proxy renders at 1/2 width and height (upscale_2x)
+
+// --- Constants ---
+#define MAX_COORD 80.0f
+
+#define TYPE_AIZAWA 0
+#define TYPE_THOMAS 1
+#define TYPE_LORENZ 2
+#define TYPE_HALVORSEN 3
+#define TYPE_CHEN 4
+#define TYPE_HYPER_LORENZ 5                 // 4D hyperchaotic systems
+#define TYPE_HYPER_ROSSLER 6
+#define NUM_TYPES 7
+#define NUM_TYPES_3D 5                      // Types usable by bifurcation/Lyapunov modes
+
+static const char* ATTRACTOR_NAMES[NUM_TYPES] = {
+    "Aizawa", "Thomas", "Lorenz", "Halvorsen", "Chen", "HyperLorenz", "HyperRossler"
+};
+// Config keys of the per-type framing multipliers
+static const char* ATTRACTOR_CONFIG_KEYS[NUM_TYPES] = {
+    "aizawa", "thomas", "lorenz", "halvorsen", "chen", "hyper_lorenz", "hyper_rossler"
+};
+
+// State dimension per type; runs with a 4D type on screen use the 4D kernel
+static const int ATTRACTOR_DIMS[NUM_TYPES] = { 3, 3, 3, 3, 3, 4, 4 };
+#define HYPER_SUBSTEPS 4                    // Euler substeps per frame in the 4D kernel (dt = DT / 4)
+
+// Attractor-specific framing multipliers (mutable for config override)
+static float ATTRACTOR_BASE_MULTIPLIERS[NUM_TYPES] = {
+    0.8f,   // TYPE_AIZAWA - tighter (range ±2)
+    0.8f,   // TYPE_THOMAS - tighter (range ±2)
+    2.5f,   // TYPE_LORENZ - looser (range ±20-30)
+    1.2f,   // TYPE_HALVORSEN - moderate (range ±3-5)
+    2.5f,   // TYPE_CHEN - looser (range ±20-30)
+    2.5f,   // TYPE_HYPER_LORENZ - looser (range ±20-30)
+    0.8f    // TYPE_HYPER_ROSSLER - tighter (scaled range ±3-15)
+};
+
+// Run modes (-m), see libattractor.h
+#define MODE_FLOW AC_MODE_FLOW
+#define MODE_MAP AC_MODE_MAP
+#define MODE_IFS AC_MODE_IFS
+#define MODE_BIFURCATION AC_MODE_BIFURCATION
+#define MODE_LYAPUNOV AC_MODE_LYAPUNOV
+#define MODE_CALIBRATE AC_MODE_CALIBRATE
+#define MODE_STILL AC_MODE_STILL
+#define NUM_MODES AC_NUM_MODES
+
+static const char* MODE_NAMES[NUM_MODES] = { "flow", "map", "ifs", "bifurcation", "lyapunov", "calibrate", "still" };
+
+#define MAP_CLIFFORD 0
+#define MAP_DEJONG 1
+#define MAP_HENON 2
+#define MAP_SVENSSON 3
+#define NUM_MAP_TYPES 4
+
+static const char* MAP_NAMES[NUM_MAP_TYPES] = {
+    "Clifford", "De Jong", "Henon", "Svensson"
+};
+
+// Map framing multipliers (mutable for config override)
+static float MAP_BASE_MULTIPLIERS[NUM_MAP_TYPES] = {
+    0.6f,   // MAP_CLIFFORD - range ±2-3
+    0.6f,   // MAP_DEJONG - range ±2
+    0.8f,   // MAP_HENON - range ±1.5, thin
+    0.6f    // MAP_SVENSSON - range ±2-3
+};
+
+// Configurable zoom parameters (mutable for config override)
+static float cfg_zoom_oscillation = 0.0f;   // Disabled breathing effect
+static float cfg_dynamic_adjustment = 0.0f; // Disabled velocity-based zoom
+static float cfg_screen_fill_factor = 0.07f; // 5x zoom out (0.35/5)
+static float cfg_min_zoom = 60.0f;          // Prevent extreme zoom-out
+static float cfg_max_zoom = 2000.0f;        // Upper bound for tight zoom
+static float cfg_initial_cam_scale = -1.0f; // Initial camera scale (-1 = use default 100)
+static float cfg_hyper_spin = 0.004f;       // x-w view rotation per frame while a 4D type is shown
+static int cfg_symmetry = 0;                // 1 = also splat each particle's symmetry images (point render)
+static int cfg_physics_interval = 1;        // Flow mode: integrate every k-th frame with k*DT, interpolate between
+
+// Particle placement for the initial box and flow-mode respawns
+#define SAMPLER_RAND 0                      // Uniform random box, hashed diagonal respawn (original behavior)
+#define SAMPLER_R3 1                        // R3 additive recurrence (Roberts); lattice can moire in projection
+#define SAMPLER_SOBOL 2                     // 3D Sobol, digitally shifted
+static int cfg_init_sampler = SAMPLER_SOBOL;
+
+// Denoiser (accum_buffer -> denoise_buffer before tone mapping)
+static int cfg_denoise = 0;                 // 1 = joint bilateral filter
+static int cfg_denoise_radius = 2;          // Filter radius in pixels (1-4)
+static float cfg_denoise_sigma_s = 1.5f;    // Spatial falloff (pixels)
+static float cfg_denoise_sigma_r = 0.35f;   // Range falloff (log-luminance units)
+static int cfg_noise_metric = 0;            // 1 = report high-pass RMS noise of the output
+#define DENOISE_TILE 32                     // Pixels per tile side (tile + halo stays in L1/L2)
+#define DENOISE_MAX_RADIUS 4
+#define DENOISE_RANGE_LUT 64                // Range weights tabulated over |dg| in [0, 3 sigma_r)
+
+// Temporal accumulation (flow mode, point render)
+static int cfg_temporal_frames = 0;         // History length in frames (0/1 = off)
+static float cfg_temporal_reject = 1.0f;    // Log-luminance gap that discards a pixel's history
+
+// Density grid export (enabled with -v <prefix>)
+static int cfg_volume_res = 256;            // Grid cells per axis (256^3 = 64MB, 512^3 = 512MB)
+static int cfg_volume_frames = 1;           // Frames accumulated into each exported volume
+static int cfg_volume_sparse = 1;           // 1 = write only occupied 8^3 bricks, 0 = dense grid
+
+// Render mode
+#define RENDER_POINTS 0                     // Additive point splatting (default)
+#define RENDER_VOLUME 1                     // Density grid ray-marched with emission/absorption
+#define RENDER_TRAILS 2                     // Fading polylines through each particle's trail history
+static int cfg_render_mode = RENDER_POINTS;
+static int cfg_march_res = 128;             // Ray-march grid cells per axis
+static int cfg_march_steps = 128;           // Samples per ray
+static float cfg_march_absorption = 0.02f;  // Optical depth per particle-per-pixel of density
+
+// Iterated maps (MODE_MAP)
+static int cfg_map_iterations = 64;         // Iterates (= splats) per particle per frame
+#define MAP_WARMUP 8                        // Unsplatted iterates after a (re)start
+
+// Bifurcation diagram (MODE_BIFURCATION)
+static int cfg_bif_param = 1;               // Swept parameter: 0-5 = a-f (1 = Lorenz rho)
+static float cfg_bif_min = 0.0f;            // Parameter at the left edge
+static float cfg_bif_max = 200.0f;          // Parameter at the right edge
+static int cfg_bif_axis = 2;                // Plotted coordinate: 0 = x, 1 = y, 2 = z
+static int cfg_bif_maxima = 1;              // 1 = plot local maxima only, 0 = every step
+static int cfg_bif_transient = 4000;        // Unplotted steps before the first frame
+static int cfg_bif_steps = 500;             // Plotted steps per frame
+static int cfg_bif_substeps = 4;            // Euler substeps per step (dt = DT / substeps)
+#define BIF_MAX_COORD 1000.0f               // Escape bound (parameter sweeps reach large orbits)
+
+// Parameter-plane map (MODE_LYAPUNOV)
+#define LYAP_EXPONENT 0                     // Color by largest Lyapunov exponent
+#define LYAP_BASIN 1                        // Color by where the trajectory settles
+static int cfg_lyap_color = LYAP_EXPONENT;
+static int cfg_lyap_param_x = 1;            // Horizontal parameter index 0-5 (a-f)
+static float cfg_lyap_x_min = 0.0f;
+static float cfg_lyap_x_max = 100.0f;
+static int cfg_lyap_param_y = 0;            // Vertical parameter index 0-5 (a-f)
+static float cfg_lyap_y_min = 0.0f;
+static float cfg_lyap_y_max = 20.0f;
+static int cfg_lyap_transient = 1000;       // Steps before measuring
+static int cfg_lyap_steps = 2000;           // Steps averaged into the exponent
+static float cfg_lyap_scale = 2.0f;         // Exponent mapped to the top of the palette
+static int cfg_lyap_band = 32;              // Rows per streamed band
+
+// Framing calibration (-m calibrate, or auto_calibrate=1 before a flow run)
+static int cfg_auto_calibrate = 0;          // 1 = calibrate multipliers at startup
+static int cfg_calibrate_particles = 10000; // Probe population per run
+static int cfg_calibrate_trials = 3;        // Randomized parameter draws per type
+static float cfg_calibrate_fill = 0.8f;     // Share of the limiting axis the attractor should span
+#define CALIBRATE_WARMUP 1500               // Steps before measuring
+#define CALIBRATE_SNAPSHOTS 12              // Measured states per trial
+#define CALIBRATE_INTERVAL 50               // Steps between snapshots
+
+// Long-exposure still (-m still)
+static int cfg_still_warmup = 300;          // Frames before the shutter opens (camera and colors settle)
+static int cfg_still_steps = 0;             // Stop after this many exposed steps (0 = no limit)
+static float cfg_still_seconds = 600.0f;    // Stop after this much wall-clock time (0 = no limit)
+static float cfg_still_noise = 0.5f;        // Stop below this estimated RMS noise, 8-bit luma (0 = off)
+static int cfg_still_preview_every = 200;   // Steps between previews / noise estimates
+static int cfg_still_tile = 1024;           // Tile edge in pixels for tiled stills (-t), multiple of 16
+#define STILL_FOLLOW 0.05f                  // Camera smoothing rate during the warm-up (animation: 0.005)
+#define CALIBRATE_VIEWS 8                   // Orbit angles per snapshot (x 4 x-w phases for 4D)
+
+// Trail history ring buffer (RENDER_TRAILS)
+static int cfg_trail_length = 8;            // Positions kept per particle (2-64)
+#define TRAIL_QUANT (32767.0f / MAX_COORD)  // int16 steps per world unit
+#define TRAIL_MAX_STEPS 32                  // Pixel samples per rasterized segment
+
+// Particle coloring (point render)
+#define COLOR_SPEED 0                       // Heatmap of speed (default)
+#define COLOR_DENSITY 1                     // Heatmap of local density from a coarse occupancy grid
+#define COLOR_MIX 2                         // Blend of density and speed
+static int cfg_color_mode = COLOR_SPEED;
+static float cfg_color_density_mix = 0.5f;  // Density weight for COLOR_MIX
+static int cfg_occupancy_res = 32;          // Occupancy grid cells per axis (32^3 floats = 128KB)
+
+// Point-cloud export (enabled with -e <prefix>, on demand via SIGUSR1)
+static int cfg_ply_interval = 0;            // Frames between periodic dumps (0 = on demand only)
+static float cfg_ply_decimate = 1.0f;       // Fraction of particles kept (1.0 = all)
+static int cfg_ply_stratified = 1;          // 1 = one jittered pick per index stratum, 0 = random subset
+
+#define TRANSITION_FRAMES 120              // Blend duration (~2 sec at 60fps)
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846f
+#endif
+
+typedef struct { float a, b, c, d, e, f; } Params;
+
+// --- IFS / Fractal Flame (MODE_IFS) ---
+// Each transform is an affine map x' = a*x + b*y + c, y' = d*x + e*y + f,
+// followed by a weighted sum of the variations below, as in fractal flames.
+#define VAR_LINEAR 0
+#define VAR_SINUSOIDAL 1
+#define VAR_SPHERICAL 2
+#define VAR_SWIRL 3
+#define VAR_HORSESHOE 4
+#define VAR_POLAR 5
+#define NUM_VARIATIONS 6
+#define MAX_IFS_TRANSFORMS 8
+
+typedef struct {
+    float weight;                   // Relative selection probability
+    float a, b, c, d, e, f;         // Affine coefficients
+    float color;                    // Palette coordinate [0,1] the point is pulled toward
+    float var[NUM_VARIATIONS];      // Variation weights
+} IfsTransform;
+
+static IfsTransform cfg_ifs[MAX_IFS_TRANSFORMS];
+static int cfg_ifs_count = 0;               // 0 = built-in default system
+static float cfg_ifs_multiplier = 0.8f;     // Framing multiplier for MODE_IFS
+static float cfg_ifs_spin = 0.002f;         // Rotation of transform 0 per frame (radians)
+
+// Parse "ifs = weight a b c d e f color [linear sinusoidal spherical swirl horseshoe polar]"
+// Variation weights default to pure linear.
+void parse_ifs_transform(const char *line) {
+    if (cfg_ifs_count == MAX_IFS_TRANSFORMS) {
+        fprintf(stderr, "Warning: Ignoring IFS transform beyond %d\n", MAX_IFS_TRANSFORMS);
+        return;
+    }
+    const char *p = strchr(line, '=');
+    if (!p) return;
+    p++;
+
+    float v[8 + NUM_VARIATIONS];
+    int n = 0;
+    char *end;
+    while (n < 8 + NUM_VARIATIONS) {
+        float f = strtof(p, &end);
+        if (end == p) break;
+        v[n++] = f;
+        p = end;
+    }
+    if (n < 8) {
+        fprintf(stderr, "Warning: IFS transform needs weight, 6 coefficients and color: %s", line);
+        return;
+    }
+
+    IfsTransform *t = &cfg_ifs[cfg_ifs_count++];
+    memset(t, 0, sizeof(*t));
+    t->weight = v[0];
+    t->a = v[1]; t->b = v[2]; t->c = v[3]; t->d = v[4]; t->e = v[5]; t->f = v[6];
+    t->color = v[7];
+    if (n == 8) t->var[VAR_LINEAR] = 1.0f;
+    for (int k = 8; k < n; k++) t->var[k - 8] = v[k];
+}
+
+// --- Particle Groups (layered scenes, MODE_FLOW) ---
+// Each group is a contiguous index range with its own attractor, palette and
+// scene transform. Particles are stored in scene space (world * scale + offset),
+// so the camera, density grids, trails and exports all see the composed scene.
+#define MAX_GROUPS 8
+
+#define PALETTE_HEAT 0                      // Blue-green-yellow-magenta heatmap (default)
+#define PALETTE_FIRE 1                      // Black-red-yellow-white
+#define PALETTE_ICE 2                       // Deep blue-cyan-white
+#define PALETTE_MONO 3                      // Grey ramp
+#define NUM_PALETTES 4
+
+typedef struct {
+    int type;                       // Attractor type
+    float share;                    // Relative share of the particles
+    float scale;                    // Uniform world -> scene scale
+    float ox, oy, oz;               // Scene offset
+    int palette;                    // PALETTE_*
+    int ens_param;                  // Parameter swept across the group (0-5 = a-f, -1 = none)
+    float ens_spread;               // Total sweep width as a fraction of the group's value (max 1)
+} GroupSpec;
+
+static GroupSpec cfg_groups[MAX_GROUPS];
+static int cfg_group_count = 0;             // 0 = one group cycling through the attractors
+static int cfg_ensemble_param = -1;         // Ensemble sweep without groups: 0-5 = a-f, -1 = off
+static float cfg_ensemble_spread = 0.0f;    // Total sweep width as a fraction of the parameter's value (max 1)
+
+// Parse "group = type [share scale offset_x offset_y offset_z palette ens_param ens_spread]";
+// ens_spread is a fraction of the group's value, like ensemble_spread
+void parse_group(const char *line) {
+    if (cfg_group_count == MAX_GROUPS) {
+        fprintf(stderr, "Warning: Ignoring group beyond %d\n", MAX_GROUPS);
+        return;
+    }
+    const char *p = strchr(line, '=');
+    if (!p) return;
+    p++;
+
+    float v[9] = { 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, PALETTE_HEAT, -1.0f, 0.0f };
+    int n = 0;
+    char *end;
+    while (n < 9) {
+        float f = strtof(p, &end);
+        if (end == p) break;
+        v[n++] = f;
+        p = end;
+    }
+    if (n < 1 || v[0] < 0 || v[0] >= NUM_TYPES) {
+        fprintf(stderr, "Warning: Group needs an attractor type 0-%d: %s", NUM_TYPES - 1, line);
+        return;
+    }
+
+    GroupSpec *g = &cfg_groups[cfg_group_count++];
+    g->type = (int)v[0];
+    g->share = v[1] > 0.0f ? v[1] : 1.0f;
+    g->scale = v[2] > 0.0f ? v[2] : 1.0f;
+    g->ox = v[3]; g->oy = v[4]; g->oz = v[5];
+    g->palette = ((int)v[6] >= 0 && (int)v[6] < NUM_PALETTES) ? (int)v[6] : PALETTE_HEAT;
+    g->ens_param = ((int)v[7] >= 0 && (int)v[7] <= 5) ? (int)v[7] : -1;
+    g->ens_spread = fabsf(v[8]) > 1.0f ? copysignf(1.0f, v[8]) : v[8];
+}
+
+// --- Config File Parser ---
+// Apply one "key = value" line; returns 1 if it set a known key
+static int apply_config_line(const char *line) {
+    char key[64];
+    float value;
+    if (sscanf(line, " %63[^= ] = %f", key, &value) == 2 && strcmp(key, "ifs") == 0) {
+        parse_ifs_transform(line);
+    } else if (sscanf(line, " %63[^= ] = %f", key, &value) == 2 && strcmp(key, "group") == 0) {
+        parse_group(line);
+    } else if (sscanf(line, " %63[^= ] = %f", key, &value) == 2) {
+        // Per-attractor zoom multipliers
+        if (strcmp(key, "aizawa") == 0) {
+            ATTRACTOR_BASE_MULTIPLIERS[TYPE_AIZAWA] = value;
+        } else if (strcmp(key, "thomas") == 0) {
+            ATTRACTOR_BASE_MULTIPLIERS[TYPE_THOMAS] = value;
+        } else if (strcmp(key, "lorenz") == 0) {
+            ATTRACTOR_BASE_MULTIPLIERS[TYPE_LORENZ] = value;
+        } else if (strcmp(key, "halvorsen") == 0) {
+            ATTRACTOR_BASE_MULTIPLIERS[TYPE_HALVORSEN] = value;
+        } else if (strcmp(key, "chen") == 0) {
+            ATTRACTOR_BASE_MULTIPLIERS[TYPE_CHEN] = value;
+        } else if (strcmp(key, "hyper_lorenz") == 0) {
+            ATTRACTOR_BASE_MULTIPLIERS[TYPE_HYPER_LORENZ] = value;
+        } else if (strcmp(key, "hyper_rossler") == 0) {
+            ATTRACTOR_BASE_MULTIPLIERS[TYPE_HYPER_ROSSLER] = value;
+        }
+        // Per-map zoom multipliers
+        else if (strcmp(key, "clifford") == 0) {
+            MAP_BASE_MULTIPLIERS[MAP_CLIFFORD] = value;
+        } else if (strcmp(key, "dejong") == 0) {
+            MAP_BASE_MULTIPLIERS[MAP_DEJONG] = value;
+        } else if (strcmp(key, "henon") == 0) {
+            MAP_BASE_MULTIPLIERS[MAP_HENON] = value;
+        } else if (strcmp(key, "svensson") == 0) {
+            MAP_BASE_MULTIPLIERS[MAP_SVENSSON] = value;
+        }
+        // Global zoom parameters
+        else if (strcmp(key, "screen_fill_factor") == 0) {
+            cfg_screen_fill_factor = value;
+        } else if (strcmp(key, "min_zoom") == 0) {
+            cfg_min_zoom = value;
+        } else if (strcmp(key, "max_zoom") == 0) {
+            cfg_max_zoom = value;
+        } else if (strcmp(key, "zoom_oscillation") == 0) {
+            cfg_zoom_oscillation = value;
+        } else if (strcmp(key, "dynamic_adjustment") == 0) {
+            cfg_dynamic_adjustment = value;
+        } else if (strcmp(key, "initial_cam_scale") == 0) {
+            cfg_initial_cam_scale = value;
+        } else if (strcmp(key, "hyper_spin") == 0) {
+            cfg_hyper_spin = value;
+        } else if (strcmp(key, "symmetry") == 0) {
+            cfg_symmetry = (int)value;
+        } else if (strcmp(key, "init_sampler") == 0) {
+            cfg_init_sampler = (int)value;
+        } else if (strcmp(key, "physics_interval") == 0) {
+            cfg_physics_interval = (int)value;
+        } else if (strcmp(key, "ensemble_param") == 0) {
+            cfg_ensemble_param = (int)value;
+        } else if (strcmp(key, "ensemble_spread") == 0) {
+            cfg_ensemble_spread = value;
+        }
+        // Denoiser
+        else if (strcmp(key, "denoise") == 0) {
+            cfg_denoise = (int)value;
+        } else if (strcmp(key, "denoise_radius") == 0) {
+            cfg_denoise_radius = (int)value;
+        } else if (strcmp(key, "denoise_sigma_s") == 0) {
+            cfg_denoise_sigma_s = value;
+        } else if (strcmp(key, "denoise_sigma_r") == 0) {
+            cfg_denoise_sigma_r = value;
+        } else if (strcmp(key, "noise_metric") == 0) {
+            cfg_noise_metric = (int)value;
+        }
+        // Temporal accumulation
+        else if (strcmp(key, "temporal_frames") == 0) {
+            cfg_temporal_frames = (int)value;
+        } else if (strcmp(key, "temporal_reject") == 0) {
+            cfg_temporal_reject = value;
+        }
+        // Density grid export
+        else if (strcmp(key, "volume_res") == 0) {
+            cfg_volume_res = (int)value;
+        } else if (strcmp(key, "volume_frames") == 0) {
+            cfg_volume_frames = (int)value;
+        } else if (strcmp(key, "volume_sparse") == 0) {
+            cfg_volume_sparse = (int)value;
+        }
+        // Render mode
+        else if (strcmp(key, "render_mode") == 0) {
+            cfg_render_mode = (int)value;
+        } else if (strcmp(key, "march_res") == 0) {
+            cfg_march_res = (int)value;
+        } else if (strcmp(key, "march_steps") == 0) {
+            cfg_march_steps = (int)value;
+        } else if (strcmp(key, "march_absorption") == 0) {
+            cfg_march_absorption = value;
+        }
+        // Iterated maps and IFS
+        else if (strcmp(key, "map_iterations") == 0) {
+            cfg_map_iterations = (int)value;
+        } else if (strcmp(key, "ifs_multiplier") == 0) {
+            cfg_ifs_multiplier = value;
+        } else if (strcmp(key, "ifs_spin") == 0) {
+            cfg_ifs_spin = value;
+        }
+        // Bifurcation diagram
+        else if (strcmp(key, "bif_param") == 0) {
+            cfg_bif_param = (int)value;
+        } else if (strcmp(key, "bif_min") == 0) {
+            cfg_bif_min = value;
+        } else if (strcmp(key, "bif_max") == 0) {
+            cfg_bif_max = value;
+        } else if (strcmp(key, "bif_axis") == 0) {
+            cfg_bif_axis = (int)value;
+        } else if (strcmp(key, "bif_maxima") == 0) {
+            cfg_bif_maxima = (int)value;
+        } else if (strcmp(key, "bif_transient") == 0) {
+            cfg_bif_transient = (int)value;
+        } else if (strcmp(key, "bif_steps") == 0) {
+            cfg_bif_steps = (int)value;
+        } else if (strcmp(key, "bif_substeps") == 0) {
+            cfg_bif_substeps = (int)value;
+        }
+        // Parameter-plane map
+        else if (strcmp(key, "lyap_color") == 0) {
+            cfg_lyap_color = (int)value;
+        } else if (strcmp(key, "lyap_param_x") == 0) {
+            cfg_lyap_param_x = (int)value;
+        } else if (strcmp(key, "lyap_x_min") == 0) {
+            cfg_lyap_x_min = value;
+        } else if (strcmp(key, "lyap_x_max") == 0) {
+            cfg_lyap_x_max = value;
+        } else if (strcmp(key, "lyap_param_y") == 0) {
+            cfg_lyap_param_y = (int)value;
+        } else if (strcmp(key, "lyap_y_min") == 0) {
+            cfg_lyap_y_min = value;
+        } else if (strcmp(key, "lyap_y_max") == 0) {
+            cfg_lyap_y_max = value;
+        } else if (strcmp(key, "lyap_transient") == 0) {
+            cfg_lyap_transient = (int)value;
+        } else if (strcmp(key, "lyap_steps") == 0) {
+            cfg_lyap_steps = (int)value;
+        } else if (strcmp(key, "lyap_scale") == 0) {
+            cfg_lyap_scale = value;
+        } else if (strcmp(key, "lyap_band") == 0) {
+            cfg_lyap_band = (int)value;
+        }
+        // Framing calibration
+        else if (strcmp(key, "auto_calibrate") == 0) {
+            cfg_auto_calibrate = (int)value;
+        } else if (strcmp(key, "calibrate_particles") == 0) {
+            cfg_calibrate_particles = (int)value;
+        } else if (strcmp(key, "calibrate_trials") == 0) {
+            cfg_calibrate_trials = (int)value;
+        } else if (strcmp(key, "calibrate_fill") == 0) {
+            cfg_calibrate_fill = value;
+        }
+        // Long-exposure still
+        else if (strcmp(key, "still_warmup") == 0) {
+            cfg_still_warmup = (int)value;
+        } else if (strcmp(key, "still_steps") == 0) {
+            cfg_still_steps = (int)value;
+        } else if (strcmp(key, "still_seconds") == 0) {
+            cfg_still_seconds = value;
+        } else if (strcmp(key, "still_noise") == 0) {
+            cfg_still_noise = value;
+        } else if (strcmp(key, "still_preview_every") == 0) {
+            cfg_still_preview_every = (int)value;
+        } else if (strcmp(key, "still_tile") == 0) {
+            cfg_still_tile = (int)value;
+        }
+        // Trail history
+        else if (strcmp(key, "trail_length") == 0) {
+            cfg_trail_length = (int)value;
+        }
+        // Particle coloring
+        else if (strcmp(key, "color_mode") == 0) {
+            cfg_color_mode = (int)value;
+        } else if (strcmp(key, "color_density_mix") == 0) {
+            cfg_color_density_mix = value;
+        } else if (strcmp(key, "occupancy_res") == 0) {
+            cfg_occupancy_res = (int)value;
+        }
+        // Point-cloud export
+        else if (strcmp(key, "ply_interval") == 0) {
+            cfg_ply_interval = (int)value;
+        } else if (strcmp(key, "ply_decimate") == 0) {
+            cfg_ply_decimate = value;
+        } else if (strcmp(key, "ply_stratified") == 0) {
+            cfg_ply_stratified = (int)value;
+        } else {
+            return 0;
+        }
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+// Keep every setting in its valid range
+static void clamp_config(void) {
+    if (cfg_volume_res < 8) cfg_volume_res = 8;
+    if (cfg_volume_res > 1024) cfg_volume_res = 1024;
+    cfg_volume_res = (cfg_volume_res + 7) & ~7;  // Whole 8^3 bricks
+    if (cfg_volume_frames < 1) cfg_volume_frames = 1;
+    if (cfg_march_res < 8) cfg_march_res = 8;
+    if (cfg_march_res > 512) cfg_march_res = 512;
+    if (cfg_march_steps < 8) cfg_march_steps = 8;
+    if (cfg_march_absorption < 0.0f) cfg_march_absorption = 0.0f;
+    if (cfg_map_iterations < MAP_WARMUP + 1) cfg_map_iterations = MAP_WARMUP + 1;
+    if (cfg_bif_param < 0 || cfg_bif_param > 5) cfg_bif_param = 1;
+    if (cfg_bif_axis < 0 || cfg_bif_axis > 2) cfg_bif_axis = 2;
+    if (cfg_bif_transient < 0) cfg_bif_transient = 0;
+    if (cfg_bif_steps < 1) cfg_bif_steps = 1;
+    if (cfg_bif_substeps < 1) cfg_bif_substeps = 1;
+    if (cfg_ensemble_param < -1 || cfg_ensemble_param > 5) cfg_ensemble_param = -1;
+    if (fabsf(cfg_ensemble_spread) > 1.0f) cfg_ensemble_spread = copysignf(1.0f, cfg_ensemble_spread);
+    if (cfg_denoise_radius < 1) cfg_denoise_radius = 1;
+    if (cfg_denoise_radius > DENOISE_MAX_RADIUS) cfg_denoise_radius = DENOISE_MAX_RADIUS;
+    if (cfg_denoise_sigma_s <= 0.0f) cfg_denoise_sigma_s = 1.5f;
+    if (cfg_denoise_sigma_r <= 0.0f) cfg_denoise_sigma_r = 0.35f;
+    if (cfg_init_sampler < SAMPLER_RAND || cfg_init_sampler > SAMPLER_SOBOL) cfg_init_sampler = SAMPLER_SOBOL;
+    if (cfg_physics_interval < 1) cfg_physics_interval = 1;
+    if (cfg_physics_interval > 4) cfg_physics_interval = 4;  // Euler at 8*DT leaves the basin of several types
+    if (cfg_temporal_frames < 0) cfg_temporal_frames = 0;
+    if (cfg_temporal_frames > 64) cfg_temporal_frames = 64;
+    if (cfg_temporal_reject <= 0.0f) cfg_temporal_reject = 1.0f;
+    if (cfg_lyap_param_x < 0 || cfg_lyap_param_x > 5) cfg_lyap_param_x = 1;
+    if (cfg_lyap_param_y < 0 || cfg_lyap_param_y > 5) cfg_lyap_param_y = 0;
+    if (cfg_lyap_transient < 0) cfg_lyap_transient = 0;
+    if (cfg_lyap_steps < 1) cfg_lyap_steps = 1;
+    if (cfg_lyap_scale <= 0.0f) cfg_lyap_scale = 2.0f;
+    if (cfg_lyap_band < 1) cfg_lyap_band = 1;
+    if (cfg_calibrate_particles < 1000) cfg_calibrate_particles = 1000;
+    if (cfg_calibrate_trials < 1) cfg_calibrate_trials = 1;
+    if (cfg_calibrate_fill <= 0.0f || cfg_calibrate_fill > 1.0f) cfg_calibrate_fill = 0.8f;
+    if (cfg_still_warmup < 0) cfg_still_warmup = 0;
+    if (cfg_still_steps < 0) cfg_still_steps = 0;
+    if (cfg_still_seconds < 0.0f) cfg_still_seconds = 0.0f;
+    if (cfg_still_noise < 0.0f) cfg_still_noise = 0.0f;
+    if (cfg_still_preview_every < 1) cfg_still_preview_every = 1;
+    if (cfg_still_tile < 16) cfg_still_tile = 16;
+    if (cfg_still_tile > 8192) cfg_still_tile = 8192;
+    cfg_still_tile &= ~15;  // TIFF tile sizes are multiples of 16
+    if (cfg_trail_length < 2) cfg_trail_length = 2;
+    if (cfg_trail_length > 64) cfg_trail_length = 64;
+    if (cfg_color_density_mix < 0.0f) cfg_color_density_mix = 0.0f;
+    if (cfg_color_density_mix > 1.0f) cfg_color_density_mix = 1.0f;
+    if (cfg_occupancy_res < 4) cfg_occupancy_res = 4;
+    if (cfg_occupancy_res > 128) cfg_occupancy_res = 128;
+    if (cfg_ply_interval < 0) cfg_ply_interval = 0;
+    if (cfg_ply_decimate <= 0.0f || cfg_ply_decimate > 1.0f) cfg_ply_decimate = 1.0f;
+}
+
+// Settings lines of the last file loaded or reloaded, so a reload can tell
+// which lines it has not seen before
+static char **config_lines = NULL;
+static int config_line_count = 0;
+
+static int config_line_seen(const char *line) {
+    for (int k = 0; k < config_line_count; k++) {
+        if (strcmp(config_lines[k], line) == 0) return 1;
+    }
+    return 0;
+}
+
+// Read the settings lines of a config file, without comments, blank lines
+// and trailing whitespace; NULL if it cannot be opened
+static char **read_config_lines(const char *filename, int *count) {
+    FILE *f = fopen(filename, "r");
+    if (!f) return NULL;
+    char **lines = NULL;
+    int n = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        // Skip comments and empty lines
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') continue;
+        size_t len = strlen(line);
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r' || line[len - 1] == ' ' ||
+                           line[len - 1] == '\t')) line[--len] = '\0';
+        if (len == 0) continue;
+        lines = (char**)realloc(lines, (n + 1) * sizeof(char*));
+        lines[n] = (char*)malloc(len + 1);
+        memcpy(lines[n++], line, len + 1);
+    }
+    fclose(f);
+    *count = n;
+    return lines ? lines : (char**)calloc(1, sizeof(char*));
+}
+
+static void remember_config_lines(char **lines, int count) {
+    for (int k = 0; k < config_line_count; k++) free(config_lines[k]);
+    free(config_lines);
+    config_lines = lines;
+    config_line_count = count;
+}
+
+// Keys a running context reads every frame, so a reload can change them in
+// place; everything else sizes buffers or is read once at creation. Values
+// outside [min, max] are rejected rather than clamped.
+typedef struct {
+    const char *key;
+    float *f;                   // Float setting, or
+    int *i;                     // integer setting
+    float min, max;
+} LiveKey;
+
+static const LiveKey LIVE_KEYS[] = {
+    { "aizawa", &ATTRACTOR_BASE_MULTIPLIERS[TYPE_AIZAWA], NULL, 0.01f, 100.0f },
+    { "thomas", &ATTRACTOR_BASE_MULTIPLIERS[TYPE_THOMAS], NULL, 0.01f, 100.0f },
+    { "lorenz", &ATTRACTOR_BASE_MULTIPLIERS[TYPE_LORENZ], NULL, 0.01f, 100.0f },
+    { "halvorsen", &ATTRACTOR_BASE_MULTIPLIERS[TYPE_HALVORSEN], NULL, 0.01f, 100.0f },
+    { "chen", &ATTRACTOR_BASE_MULTIPLIERS[TYPE_CHEN], NULL, 0.01f, 100.0f },
+    { "hyper_lorenz", &ATTRACTOR_BASE_MULTIPLIERS[TYPE_HYPER_LORENZ], NULL, 0.01f, 100.0f },
+    { "hyper_rossler", &ATTRACTOR_BASE_MULTIPLIERS[TYPE_HYPER_ROSSLER], NULL, 0.01f, 100.0f },
+    { "clifford", &MAP_BASE_MULTIPLIERS[MAP_CLIFFORD], NULL, 0.01f, 100.0f },
+    { "dejong", &MAP_BASE_MULTIPLIERS[MAP_DEJONG], NULL, 0.01f, 100.0f },
+    { "henon", &MAP_BASE_MULTIPLIERS[MAP_HENON], NULL, 0.01f, 100.0f },
+    { "svensson", &MAP_BASE_MULTIPLIERS[MAP_SVENSSON], NULL, 0.01f, 100.0f },
+    { "ifs_multiplier", &cfg_ifs_multiplier, NULL, 0.01f, 100.0f },
+    { "screen_fill_factor", &cfg_screen_fill_factor, NULL, 0.001f, 1.0f },
+    { "min_zoom", &cfg_min_zoom, NULL, 0.001f, 1e6f },
+    { "max_zoom", &cfg_max_zoom, NULL, 0.001f, 1e6f },
+    { "zoom_oscillation", &cfg_zoom_oscillation, NULL, 0.0f, 0.9f },
+    { "dynamic_adjustment", &cfg_dynamic_adjustment, NULL, 0.0f, 10.0f },
+    { "hyper_spin", &cfg_hyper_spin, NULL, 0.0f, 1.0f },
+    { "ifs_spin", &cfg_ifs_spin, NULL, -1.0f, 1.0f },
+    { "denoise_radius", NULL, &cfg_denoise_radius, 1.0f, DENOISE_MAX_RADIUS },
+    { "denoise_sigma_s", &cfg_denoise_sigma_s, NULL, 0.01f, 100.0f },
+    { "denoise_sigma_r", &cfg_denoise_sigma_r, NULL, 0.01f, 100.0f },
+    { "temporal_reject", &cfg_temporal_reject, NULL, 0.01f, 100.0f },
+    { "march_steps", NULL, &cfg_march_steps, 8.0f, 4096.0f },
+    { "march_absorption", &cfg_march_absorption, NULL, 0.0f, 100.0f },
+    { "map_iterations", NULL, &cfg_map_iterations, MAP_WARMUP + 1, 65536.0f },
+    { "color_density_mix", &cfg_color_density_mix, NULL, 0.0f, 1.0f },
+    { "ply_interval", NULL, &cfg_ply_interval, 0.0f, 1e9f },
+    { "ply_decimate", &cfg_ply_decimate, NULL, 0.0001f, 1.0f },
+};
+#define NUM_LIVE_KEYS ((int)(sizeof(LIVE_KEYS) / sizeof(LIVE_KEYS[0])))
+
+void load_config(const char* filename) {
+    int count;
+    char **lines = read_config_lines(filename, &count);
+    if (!lines) {
+        fprintf(stderr, "Warning: Could not open config file '%s', using defaults\n", filename);
+        return;
+    }
+
+    for (int k = 0; k < count; k++) apply_config_line(lines[k]);
+    remember_config_lines(lines, count);
+
+    fprintf(stderr, "Loaded config from '%s'\n", filename);
+    fprintf(stderr, "  Multipliers: aizawa=%.2f thomas=%.2f lorenz=%.2f halvorsen=%.2f chen=%.2f\n",
+            ATTRACTOR_BASE_MULTIPLIERS[TYPE_AIZAWA],
+            ATTRACTOR_BASE_MULTIPLIERS[TYPE_THOMAS],
+            ATTRACTOR_BASE_MULTIPLIERS[TYPE_LORENZ],
+            ATTRACTOR_BASE_MULTIPLIERS[TYPE_HALVORSEN],
+            ATTRACTOR_BASE_MULTIPLIERS[TYPE_CHEN]);
+    fprintf(stderr, "  screen_fill=%.3f min_zoom=%.1f max_zoom=%.1f\n",
+            cfg_screen_fill_factor, cfg_min_zoom, cfg_max_zoom);
+    clamp_config();
+}
+
+// --- CPU Helper ---
+// Host randomness comes from splitmix64 streams owned by the caller (each
+// context keeps one for placement and one for scene decisions), so contexts
+// never share generator state
+static uint64_t stream_next(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Sampler shifts: the high 32 bits of the next draw
+static uint32_t stream_u32(uint64_t *state) {
+    return (uint32_t)(stream_next(state) >> 32);
+}
+
+float rand_range_cpu(uint64_t *stream, float min, float max) {
+    float u = (stream_next(stream) >> 40) * (1.0f / 16777215.0f);
+    return min + u * (max - min);
+}
+
+// --- GPU Helper: Hash ---
+// Integer hash -> [0,1), for reproducible per-particle randomness
+#pragma acc routine seq
+static inline float hash_unit(uint32_t v) {
+    v ^= v >> 16; v *= 0x7feb352dU;
+    v ^= v >> 15; v *= 0x846ca68bU;
+    v ^= v >> 16;
+    return (v >> 8) * (1.0f / 16777216.0f);
+}
+
+// --- GPU Helper: Low-Discrepancy Points ---
+// Point n of a 3D low-discrepancy sequence in [0,1)^3, computed from the index
+// alone so every particle can place itself in parallel. Both sequences run in
+// 32-bit fixed point (exact for any n) and are randomized per run by `shift`:
+// added for R3 (Cranley-Patterson rotation), XORed for Sobol (digital shift).
+typedef struct {
+    int kind;
+    uint32_t shift[3];
+    uint32_t round;         // Physics steps so far; respawns in step k draw from block k + 1
+} Sampler;
+
+#pragma acc routine seq
+static inline void sample_point(Sampler smp, uint32_t n, float *u0, float *u1, float *u2) {
+    uint32_t a, b, c;
+    if (smp.kind == SAMPLER_SOBOL) {
+        // Dimensions 1-3 of Joe-Kuo: van der Corput, x + 1 (m = 1), x^2 + x + 1
+        // (m = 1, 3); direction numbers come from their recurrences on the fly
+        uint32_t v2 = 1u << 31, v3 = 1u << 31, v3_prev = 0;
+        a = b = c = 0;
+        for (int k = 0; k < 32 && (n >> k); k++) {
+            if ((n >> k) & 1) { a ^= 1u << (31 - k); b ^= v2; c ^= v3; }
+            uint32_t n2 = v2 ^ (v2 >> 1);
+            uint32_t n3 = (k == 0) ? 3u << 30 : v3 ^ v3_prev ^ (v3_prev >> 2);
+            v2 = n2;
+            v3_prev = v3; v3 = n3;
+        }
+        a ^= smp.shift[0]; b ^= smp.shift[1]; c ^= smp.shift[2];
+    } else {
+        // alpha_k = 1/g^k with g the root of x^4 = x + 1, as 2^32 fractions
+        a = smp.shift[0] + n * 3518319154u;
+        b = smp.shift[1] + n * 2882110344u;
+        c = smp.shift[2] + n * 2360945575u;
+    }
+    *u0 = (a >> 8) * (1.0f / 16777216.0f);
+    *u1 = (b >> 8) * (1.0f / 16777216.0f);
+    *u2 = (c >> 8) * (1.0f / 16777216.0f);
+}
+
+// Sequence index of particle id's respawn in the current step (wraps after
+// 2^32 points, which only repeats the sequence)
+#pragma acc routine seq
+static inline uint32_t respawn_index(Sampler smp, int id, int id_total) {
+    return (uint32_t)id_total * (smp.round + 1) + (uint32_t)id;
+}
+
+// --- GPU Helper: Heatmap ---
+#pragma acc routine seq
+void get_heatmap_color(float t, float *r, float *g, float *b) {
+    if (t < 0.0f) t = 0.0f; if (t > 1.0f) t = 1.0f;
+    // Boosted saturation
+    if (t < 0.2f) { *r = 0.0f; *g = t*5.0f; *b = 1.0f; } 
+    else if (t < 0.5f) { *r = 0.0f; *g = 1.0f; *b = 1.0f - (t-0.2f)*3.3f; } 
+    else if (t < 0.8f) { *r = (t-0.5f)*3.3f; *g = 1.0f; *b = 0.0f; } 
+    else { *r = 1.0f; *g = 1.0f - (t-0.8f)*5.0f; *b = (t-0.8f)*5.0f; }
+}
+
+// Per-group palettes; PALETTE_HEAT is the heatmap above
+#pragma acc routine seq
+void get_palette_color(int palette, float t, float *r, float *g, float *b) {
+    if (palette == PALETTE_HEAT) { get_heatmap_color(t, r, g, b); return; }
+    if (t < 0.0f) t = 0.0f; if (t > 1.0f) t = 1.0f;
+    if (palette == PALETTE_FIRE) {
+        *r = fminf(1.0f, 0.25f + t * 2.0f); *g = fminf(1.0f, t * 1.6f); *b = fmaxf(0.0f, t * 2.0f - 1.0f);
+    } else if (palette == PALETTE_ICE) {
+        *r = fmaxf(0.0f, t * 2.0f - 1.0f); *g = fminf(1.0f, 0.1f + t * 1.4f); *b = 1.0f;
+    } else {
+        *r = *g = *b = 0.3f + 0.7f * t;
+    }
+}
+
+// --- GPU Helper: Attractor Equations ---
+// Right-hand side of each flow, shared by every kernel that integrates one
+#pragma acc routine seq
+void attractor_rhs(int type, Params p, float x, float y, float z, float *dx, float *dy, float *dz) {
+    if (type == TYPE_AIZAWA) {
+        *dx = (z - p.b) * x - p.d * y;
+        *dy = p.d * x + (z - p.b) * y;
+        *dz = p.c + p.a * z - (z*z*z)/3.0f - (x*x + y*y) * (1.0f + p.e * z) + p.f * z * x*x*x;
+    } else if (type == TYPE_THOMAS) {
+        *dx = sinf(y) - p.b * x; *dy = sinf(z) - p.b * y; *dz = sinf(x) - p.b * z;
+    } else if (type == TYPE_LORENZ) {
+        *dx = p.a * (y - x); *dy = x * (p.b - z) - y; *dz = x * y - p.c * z;
+    } else if (type == TYPE_HALVORSEN) {
+        *dx = -p.a*x - 4*y - 4*z - y*y; *dy = -p.a*y - 4*z - 4*x - z*z; *dz = -p.a*z - 4*x - 4*y - x*x;
+    } else if (type == TYPE_CHEN) {
+        *dx = p.a * (y - x); *dy = (p.c - p.a)*x - x*z + p.c*y; *dz = x*y - p.b*z;
+    } else {
+        *dx = 0.0f; *dy = 0.0f; *dz = 0.0f;
+    }
+}
+
+// 4D right-hand side. 3D flows relax w toward zero, so the fourth axis fades
+// out when blending from a hyperchaotic system back to a 3D one.
+#pragma acc routine seq
+void attractor_rhs4(int type, Params p, float x, float y, float z, float w,
+                    float *dx, float *dy, float *dz, float *dw) {
+    if (type == TYPE_HYPER_LORENZ) {
+        // Wang & Wang (2008); w is stored scaled by 1/10 to share Lorenz's range
+        *dx = p.a * (y - x) + 10.0f * w; *dy = p.b * x - y - x * z;
+        *dz = x * y - p.c * z; *dw = -0.1f * y * z + p.d * w;
+    } else if (type == TYPE_HYPER_ROSSLER) {
+        // Rossler (1979) with all coordinates scaled by 1/5 (z spikes stay inside
+        // MAX_COORD), run at 2x speed since its orbit is far slower than Lorenz's
+        *dx = 2.0f * (-y - z); *dy = 2.0f * (x + p.a * y + w);
+        *dz = 2.0f * (p.b * 0.2f + 5.0f * x * z); *dw = 2.0f * (-p.c * z + p.d * w);
+    } else {
+        attractor_rhs(type, p, x, y, z, dx, dy, dz);
+        *dw = -w;
+    }
+}
+
+void log_attractor(FILE *logf, int mins, int secs, int type, Params p) {
+    if (!logf) return;
+    switch(type) {
+        case TYPE_AIZAWA:
+            fprintf(logf, "%02d:%02d %s a=%.3f b=%.3f c=%.3f d=%.3f e=%.3f f=%.3f\n",
+                    mins, secs, ATTRACTOR_NAMES[type], p.a, p.b, p.c, p.d, p.e, p.f);
+            break;
+        case TYPE_THOMAS:
+            fprintf(logf, "%02d:%02d %s b=%.4f\n", mins, secs, ATTRACTOR_NAMES[type], p.b);
+            break;
+        case TYPE_LORENZ:
+            fprintf(logf, "%02d:%02d %s sigma=%.2f rho=%.2f beta=%.3f\n",
+                    mins, secs, ATTRACTOR_NAMES[type], p.a, p.b, p.c);
+            break;
+        case TYPE_HALVORSEN:
+            fprintf(logf, "%02d:%02d %s a=%.3f\n", mins, secs, ATTRACTOR_NAMES[type], p.a);
+            break;
+        case TYPE_CHEN:
+            fprintf(logf, "%02d:%02d %s a=%.2f b=%.2f c=%.2f\n",
+                    mins, secs, ATTRACTOR_NAMES[type], p.a, p.b, p.c);
+            break;
+        case TYPE_HYPER_LORENZ:
+            fprintf(logf, "%02d:%02d %s sigma=%.2f rho=%.2f beta=%.3f r=%.3f\n",
+                    mins, secs, ATTRACTOR_NAMES[type], p.a, p.b, p.c, p.d);
+            break;
+        case TYPE_HYPER_ROSSLER:
+            fprintf(logf, "%02d:%02d %s a=%.3f b=%.2f c=%.2f d=%.3f\n",
+                    mins, secs, ATTRACTOR_NAMES[type], p.a, p.b, p.c, p.d);
+            break;
+    }
+}
+
+Params get_target_params(int type, uint64_t *stream) {
+    Params p = {0};
+    switch(type) {
+        case TYPE_AIZAWA:
+            p.a=0.95f; p.b=0.7f; p.c=0.6f; p.d=3.5f; p.e=0.25f; p.f=0.1f;
+            p.d += rand_range_cpu(stream, -0.5f, 0.5f); 
+            break;
+        case TYPE_THOMAS:
+            p.b = 0.19f + rand_range_cpu(stream, -0.02f, 0.02f);
+            break;
+        case TYPE_LORENZ:
+            p.a=10.0f; p.b=28.0f; p.c=2.66f;
+            p.b += rand_range_cpu(stream, -5.0f, 5.0f);
+            break;
+        case TYPE_HALVORSEN:
+            p.a = 1.4f + rand_range_cpu(stream, -0.2f, 0.2f);
+            break;
+        case TYPE_CHEN: 
+            p.a = 40.0f; p.b = 3.0f; p.c = 28.0f;
+            break;
+        case TYPE_HYPER_LORENZ:
+            p.a=10.0f; p.b=28.0f; p.c=2.66f; p.d=-1.0f;
+            p.d += rand_range_cpu(stream, -0.3f, 0.3f);  // Hyperchaotic for -1.52 < r < -0.06
+            break;
+        case TYPE_HYPER_ROSSLER:
+            p.a = 0.25f; p.b = 3.0f; p.c = 0.5f; p.d = 0.05f;
+            break;
+    }
+    return p;
+}
+
+// --- Attractor Symmetries ---
+// Signed permutations that map each attractor onto itself (besides the
+// identity). With symmetry=1 the point renderer also splats these images of
+// every particle: 2-3x the apparent density for no extra physics.
+#define MAX_SYMMETRIES 2
+
+typedef struct {
+    int count;
+    float m[MAX_SYMMETRIES][9];     // Row-major 3x3: image = M * (x, y, z)
+    float w_sign[MAX_SYMMETRIES];   // 4D types: w -> w_sign * w
+} SymmetryTable;
+
+#define SYM_CYCLIC { { 0,1,0, 0,0,1, 1,0,0 }, { 0,0,1, 1,0,0, 0,1,0 } }, { 1, 1 }
+#define SYM_FLIP_XY { { -1,0,0, 0,-1,0, 0,0,1 } }
+
+static const SymmetryTable ATTRACTOR_SYMMETRIES[NUM_TYPES] = {
+    { 0 },                          // Aizawa: the f*z*x^3 term breaks its rotation symmetry
+    { 2, SYM_CYCLIC },              // Thomas: (x,y,z) -> (y,z,x) -> (z,x,y)
+    { 1, SYM_FLIP_XY, { 1 } },      // Lorenz: (x,y,z) -> (-x,-y,z)
+    { 2, SYM_CYCLIC },              // Halvorsen: cyclic, like Thomas
+    { 1, SYM_FLIP_XY, { 1 } },      // Chen: (x,y,z) -> (-x,-y,z)
+    { 1, SYM_FLIP_XY, { -1 } },     // HyperLorenz: (x,y,z,w) -> (-x,-y,z,-w)
+    { 0 }                           // HyperRossler: none
+};
+
+// One weighted image as resolved for a group this frame
+typedef struct {
+    float m[9];
+    float w_sign;
+    float weight;                   // Fades images in/out across type transitions
+} SymImage;
+
+// --- Flow Kernels ---
+// Runtime state of one particle group: its index range and what it runs this frame
+typedef struct {
+    int begin, end;                 // Particle index range [begin, end)
+    int id_stride, id_begin, id_count, id_total;  // Identity of particle i is particle_id(i, ...), in the
+                                    // full population's range [id_begin, id_begin + id_count) of id_total;
+                                    // a proxy subsample keeps the seeding and respawns of those particles
+    int type, prev_type;            // Blended attractor pair (equal outside transitions)
+    Params p;
+    float scale, ox, oy, oz;        // Scene transform (world * scale + offset)
+    float share;                    // Fraction of the particles (weights the scene multiplier)
+    int palette;                    // PALETTE_*
+    int dims;                       // 4 = 4D kernel and x-w view rotation this frame
+    float smooth_max_spd;           // Speed normalization for coloring
+    int ensemble;                   // 1 = params vary across the range, color by offset
+    Params dp;                      // Ensemble sweep: particle k of N gets p + ((k+0.5)/N - 0.5) * dp
+    int num_images;                 // Symmetry images splatted per particle (besides itself)
+    SymImage images[2 * MAX_SYMMETRIES];
+} Group;
+
+// Resolve a group's symmetry images for this frame. During a transition the
+// current type's images fade in with the blend and the previous type's fade out.
+void resolve_symmetry_images(Group *g, float blend) {
+    g->num_images = 0;
+    int blending = (g->prev_type != g->type && blend < 1.0f);
+    for (int pass = 0; pass < 1 + blending; pass++) {
+        const SymmetryTable *sym = &ATTRACTOR_SYMMETRIES[pass == 0 ? g->type : g->prev_type];
+        float weight = !blending ? 1.0f : (pass == 0 ? blend : 1.0f - blend);
+        if (weight <= 0.0f) continue;
+        for (int k = 0; k < sym->count; k++) {
+            SymImage *im = &g->images[g->num_images++];
+            memcpy(im->m, sym->m[k], sizeof(im->m));
+            im->w_sign = sym->w_sign[k];
+            im->weight = weight;
+        }
+    }
+}
+
+// Full-population identity of proxy particle i: one id from each block of
+// id_stride, at a hashed offset (every id_stride-th point of a low-discrepancy
+// sequence is a lattice-aligned slice, not a fair subsample). Particles on the
+// stats grid keep the block start, so the camera measures the same particles
+// as a full render.
+#pragma acc routine seq
+static inline int particle_id(int i, int id_stride, int id_end) {
+    int id = i * id_stride;
+    if (id_stride == 1 || i % (STATS_STRIDE / id_stride) == 0) return id;
+    int span = (id_end - id < id_stride) ? id_end - id : id_stride;
+    return id + (int)(hash_unit((uint32_t)i ^ 0x5bd1e995U) * span);
+}
+
+// Ensemble coordinate of particle i in [0,1), derived from its index so no
+// per-particle parameter storage is needed
+#pragma acc routine seq
+static inline float ensemble_coord(int i, int begin, float inv_count) {
+    return ((i - begin) + 0.5f) * inv_count;
+}
+
+// Params of one ensemble member: a branch-free FMA per field, so the physics
+// loop stays vectorizable (dp is all zeros for plain groups)
+#pragma acc routine seq
+static inline Params ensemble_params(Params p, Params dp, float u) {
+    float s = u - 0.5f;
+    p.a += s * dp.a; p.b += s * dp.b; p.c += s * dp.c;
+    p.d += s * dp.d; p.e += s * dp.e; p.f += s * dp.f;
+    return p;
+}
+
+// Trail slot value of a world coordinate. Scale x attractor extent can put a
+// group past MAX_COORD even with an in-range offset, so saturate rather than
+// let the int16 wrap and draw a segment across the frame.
+#pragma acc routine seq
+static inline int16_t quantize_trail(float v) {
+    return (int16_t)lrintf(fminf(fmaxf(v * TRAIL_QUANT, -32767.0f), 32767.0f));
+}
+
+// One launch per group range, so every lane in a batch evaluates the same
+// attractor pair. Particles are integrated in world space and stored in the
+// group's scene space; the trail ring records scene positions.
+void integrate_flow_3d(float *x_, float *y_, float *z_, float *vx_, float *vy_, float *vz_, int n,
+                       Group g, float blend, float dt, Sampler smp, int16_t *tx, int16_t *ty, int16_t *tz, int trail_len, int trail_head) {
+    int type = g.type, prev_type = g.prev_type;
+    Params p0 = g.p, dp = g.dp;
+    float scale = g.scale, inv_scale = 1.0f / g.scale, ox = g.ox, oy = g.oy, oz = g.oz;
+    float inv_count = 1.0f / g.id_count;
+    int id_stride = g.id_stride, id_begin = g.id_begin, id_end = g.id_begin + g.id_count, id_total = g.id_total;
+
+    #pragma acc parallel loop present(x_, y_, z_, vx_, vy_, vz_, tx, ty, tz)
+    for (int i = g.begin; i < g.end; i++) {
+        int id = particle_id(i, id_stride, id_end);
+        float x = (x_[i] - ox) * inv_scale; float y = (y_[i] - oy) * inv_scale; float z = (z_[i] - oz) * inv_scale;
+        Params p = ensemble_params(p0, dp, ensemble_coord(id, id_begin, inv_count));
+
+        // Compute velocity for CURRENT and PREVIOUS attractor (for blending)
+        float dx_cur, dy_cur, dz_cur, dx_prev, dy_prev, dz_prev;
+        attractor_rhs(type, p, x, y, z, &dx_cur, &dy_cur, &dz_cur);
+        attractor_rhs(prev_type, p, x, y, z, &dx_prev, &dy_prev, &dz_prev);
+
+        // Blend velocities: lerp from previous to current
+        float dx = dx_prev + (dx_cur - dx_prev) * blend;
+        float dy = dy_prev + (dy_cur - dy_prev) * blend;
+        float dz = dz_prev + (dz_cur - dz_prev) * blend;
+
+        x += dx*dt; y += dy*dt; z += dz*dt;
+
+        int respawned = 0;
+        if (fabs(x) > MAX_COORD || fabs(y) > MAX_COORD || fabs(z) > MAX_COORD || isnan(x)) {
+            if (smp.kind == SAMPLER_RAND) {
+                float hash = (float)((id * 1327) % 1000) / 1000.0f;
+                x = (hash - 0.5f) * 4.0f; y = (hash - 0.5f) * 4.0f; z = (hash - 0.5f) * 4.0f;
+            } else {
+                // Respawn points continue the sequence past the initial placement,
+                // one block of id_total points per step so repeat respawns move on
+                float u0, u1, u2;
+                sample_point(smp, respawn_index(smp, id, id_total), &u0, &u1, &u2);
+                x = (u0 - 0.5f) * 4.0f; y = (u1 - 0.5f) * 4.0f; z = (u2 - 0.5f) * 4.0f;
+            }
+            dx=0; dy=0; dz=0;
+            respawned = 1;
+        }
+
+        x = x * scale + ox; y = y * scale + oy; z = z * scale + oz;
+        x_[i] = x; y_[i] = y; z_[i] = z;
+        vx_[i] = dx; vy_[i] = dy; vz_[i] = dz;
+
+        // Record into the trail ring; a respawn overwrites the whole history
+        // so no segment is drawn across the jump
+        if (trail_len > 0) {
+            int16_t qx = quantize_trail(x);
+            int16_t qy = quantize_trail(y);
+            int16_t qz = quantize_trail(z);
+            for (int k = 0; k < trail_len; k++) {
+                if (!respawned && k != trail_head) continue;
+                size_t t_idx = (size_t)k * n + i;
+                tx[t_idx] = qx; ty[t_idx] = qy; tz[t_idx] = qz;
+            }
+        }
+    }
+}
+
+// 4D counterpart, used for groups where a 4D type is involved. Keeping it
+// separate means 3D groups never touch the w arrays; the fixed substep count
+// unrolls at compile time. w is stored unscaled (it never reaches the screen
+// directly, only through the x-w view rotation).
+void integrate_flow_4d(float *x_, float *y_, float *z_, float *w_,
+                       float *vx_, float *vy_, float *vz_, float *vw_, int n,
+                       Group g, float blend, float step, Sampler smp, int16_t *tx, int16_t *ty, int16_t *tz, int trail_len, int trail_head) {
+    const float dt = step / HYPER_SUBSTEPS;
+    int type = g.type, prev_type = g.prev_type;
+    Params p0 = g.p, dp = g.dp;
+    float scale = g.scale, inv_scale = 1.0f / g.scale, ox = g.ox, oy = g.oy, oz = g.oz;
+    float inv_count = 1.0f / g.id_count;
+    int id_stride = g.id_stride, id_begin = g.id_begin, id_end = g.id_begin + g.id_count, id_total = g.id_total;
+
+    #pragma acc parallel loop present(x_, y_, z_, w_, vx_, vy_, vz_, vw_, tx, ty, tz)
+    for (int i = g.begin; i < g.end; i++) {
+        int id = particle_id(i, id_stride, id_end);
+        float x = (x_[i] - ox) * inv_scale, y = (y_[i] - oy) * inv_scale, z = (z_[i] - oz) * inv_scale, w = w_[i];
+        Params p = ensemble_params(p0, dp, ensemble_coord(id, id_begin, inv_count));
+        float dx = 0.0f, dy = 0.0f, dz = 0.0f, dw = 0.0f;
+
+        #pragma acc loop seq
+        for (int s = 0; s < HYPER_SUBSTEPS; s++) {
+            float dx_cur, dy_cur, dz_cur, dw_cur, dx_prev, dy_prev, dz_prev, dw_prev;
+            attractor_rhs4(type, p, x, y, z, w, &dx_cur, &dy_cur, &dz_cur, &dw_cur);
+            attractor_rhs4(prev_type, p, x, y, z, w, &dx_prev, &dy_prev, &dz_prev, &dw_prev);
+            dx = dx_prev + (dx_cur - dx_prev) * blend;
+            dy = dy_prev + (dy_cur - dy_prev) * blend;
+            dz = dz_prev + (dz_cur - dz_prev) * blend;
+            dw = dw_prev + (dw_cur - dw_prev) * blend;
+            x += dx*dt; y += dy*dt; z += dz*dt; w += dw*dt;
+        }
+
+        int respawned = 0;
+        if (fabsf(x) > MAX_COORD || fabsf(y) > MAX_COORD || fabsf(z) > MAX_COORD ||
+            fabsf(w) > MAX_COORD || isnan(x) || isnan(w)) {
+            float hash = (float)((id * 1327) % 1000) / 1000.0f;
+            float u0 = hash, u1 = hash, u2 = hash;
+            if (smp.kind != SAMPLER_RAND) sample_point(smp, respawn_index(smp, id, id_total), &u0, &u1, &u2);
+            if (type == TYPE_HYPER_ROSSLER) {
+                // Small basin: respawn close to a point on the attractor, with
+                // per-particle jitter so mass respawns do not collapse onto a few orbits
+                if (smp.kind == SAMPLER_RAND) { u0 = hash_unit(4*id); u1 = hash_unit(4*id+1); u2 = hash_unit(4*id+2); }
+                x = -2.0f + (u0 - 0.5f) * 0.2f;
+                y = -1.2f + (u1 - 0.5f) * 0.2f;
+                z = 0.0f;
+                w = 2.0f + (u2 - 0.5f) * 0.2f;
+            } else {
+                x = (u0 - 0.5f) * 4.0f; y = (u1 - 0.5f) * 4.0f; z = (u2 - 0.5f) * 4.0f; w = 0.0f;
+            }
+            dx = 0; dy = 0; dz = 0; dw = 0;
+            respawned = 1;
+        }
+
+        x = x * scale + ox; y = y * scale + oy; z = z * scale + oz;
+        x_[i] = x; y_[i] = y; z_[i] = z; w_[i] = w;
+        vx_[i] = dx; vy_[i] = dy; vz_[i] = dz; vw_[i] = dw;
+
+        if (trail_len > 0) {
+            int16_t qx = quantize_trail(x);
+            int16_t qy = quantize_trail(y);
+            int16_t qz = quantize_trail(z);
+            for (int k = 0; k < trail_len; k++) {
+                if (!respawned && k != trail_head) continue;
+                size_t t_idx = (size_t)k * n + i;
+                tx[t_idx] = qx; ty[t_idx] = qy; tz[t_idx] = qz;
+            }
+        }
+    }
+}
+
+// Reduced-rate physics: every k-th frame key0 takes a copy of the particle
+// state and the flow kernels advance the state by span = k*DT; the frames in
+// between draw positions on the straight segment between the two. A 3D key is
+// a single Euler step, so that segment is exactly the path the engine
+// integrated (4D types take substeps and get the chord). The state is the
+// positions in key1 plus the h_ velocities, so the drawn particles carry the
+// velocity of the current step. Respawned particles (zeroed velocity) snap to
+// key1. Components are x, y, z, w, then vx, vy, vz, vw.
+#define KEY_COMPONENTS 8
+
+void interpolate_particles(float *const *k0, float *const *k1, float *x_, float *y_, float *z_, float *w_,
+                           Group g, float s) {
+    const float *x0 = k0[0], *y0 = k0[1], *z0 = k0[2], *w0 = k0[3];
+    const float *x1 = k1[0], *y1 = k1[1], *z1 = k1[2], *w1 = k1[3];
+    const float *vx1 = k1[4], *vy1 = k1[5], *vz1 = k1[6];
+    int has_w = (g.dims == 4);
+
+    #pragma acc parallel loop present(x0, y0, z0, w0, x1, y1, z1, w1, vx1, vy1, vz1, x_, y_, z_, w_)
+    for (int i = g.begin; i < g.end; i++) {
+        if (vx1[i] == 0.0f && vy1[i] == 0.0f && vz1[i] == 0.0f) {
+            x_[i] = x1[i]; y_[i] = y1[i]; z_[i] = z1[i];
+            if (has_w) w_[i] = w1[i];
+            continue;
+        }
+        x_[i] = x0[i] + (x1[i] - x0[i]) * s;
+        y_[i] = y0[i] + (y1[i] - y0[i]) * s;
+        z_[i] = z0[i] + (z1[i] - z0[i]) * s;
+        if (has_w) w_[i] = w0[i] + (w1[i] - w0[i]) * s;
+    }
+}
+
+void log_map(FILE *logf, int mins, int secs, int type, Params p) {
+    if (!logf) return;
+    if (type == MAP_HENON) {
+        fprintf(logf, "%02d:%02d %s a=%.3f b=%.3f\n", mins, secs, MAP_NAMES[type], p.a, p.b);
+    } else {
+        fprintf(logf, "%02d:%02d %s a=%.3f b=%.3f c=%.3f d=%.3f\n",
+                mins, secs, MAP_NAMES[type], p.a, p.b, p.c, p.d);
+    }
+}
+
+Params get_map_params(int type, uint64_t *stream) {
+    Params p = {0};
+    switch(type) {
+        case MAP_CLIFFORD:
+            p.a=-1.4f; p.b=1.6f; p.c=1.0f; p.d=0.7f;
+            p.a += rand_range_cpu(stream, -0.1f, 0.1f); p.d += rand_range_cpu(stream, -0.1f, 0.1f);
+            break;
+        case MAP_DEJONG:
+            p.a=-2.0f; p.b=-2.0f; p.c=-1.2f; p.d=2.0f;
+            p.c += rand_range_cpu(stream, -0.1f, 0.1f);
+            break;
+        case MAP_HENON:
+            p.a = 1.4f + rand_range_cpu(stream, -0.02f, 0.0f); p.b = 0.3f;
+            break;
+        case MAP_SVENSSON:
+            p.a=1.5f; p.b=-1.8f; p.c=1.6f; p.d=0.9f;
+            p.b += rand_range_cpu(stream, -0.1f, 0.1f);
+            break;
+    }
+    return p;
+}
+
+// --- Density Grid (volume export) ---
+typedef struct { float min_x, min_y, min_z, max_x, max_y, max_z; } Bounds;
+
+// Axis-aligned bounds of a strided particle sample, padded by 5% per side
+Bounds compute_particle_bounds(const float *x, const float *y, const float *z, int n, int stride) {
+    float min_x = FLT_MAX, min_y = FLT_MAX, min_z = FLT_MAX;
+    float max_x = -FLT_MAX, max_y = -FLT_MAX, max_z = -FLT_MAX;
+    #pragma acc parallel loop present(x, y, z) reduction(min:min_x, min_y, min_z) reduction(max:max_x, max_y, max_z)
+    for (int i = 0; i < n; i += stride) {
+        float px = x[i]; float py = y[i]; float pz = z[i];
+        if (px < min_x) min_x = px; if (px > max_x) max_x = px;
+        if (py < min_y) min_y = py; if (py > max_y) max_y = py;
+        if (pz < min_z) min_z = pz; if (pz > max_z) max_z = pz;
+    }
+
+    float pad_x = (max_x - min_x) * 0.05f + 1e-3f;
+    float pad_y = (max_y - min_y) * 0.05f + 1e-3f;
+    float pad_z = (max_z - min_z) * 0.05f + 1e-3f;
+    Bounds b = { min_x - pad_x, min_y - pad_y, min_z - pad_z,
+                 max_x + pad_x, max_y + pad_y, max_z + pad_z };
+    return b;
+}
+
+// Bin particle positions into a res^3 grid (x fastest) with atomic accumulation
+void splat_density_grid(const float *x, const float *y, const float *z, int n,
+                        float *grid, int res, Bounds b) {
+    float min_x = b.min_x, min_y = b.min_y, min_z = b.min_z;
+    float sx = res / (b.max_x - b.min_x);
+    float sy = res / (b.max_y - b.min_y);
+    float sz = res / (b.max_z - b.min_z);
+
+    #pragma acc parallel loop present(x, y, z, grid)
+    for (int i = 0; i < n; i++) {
+        float fx = (x[i] - min_x) * sx;
+        float fy = (y[i] - min_y) * sy;
+        float fz = (z[i] - min_z) * sz;
+        if (fx >= 0.0f && fx < res && fy >= 0.0f && fy < res && fz >= 0.0f && fz < res) {
+            size_t idx = ((size_t)(int)fz * res + (int)fy) * res + (int)fx;
+            #pragma acc atomic update
+            grid[idx] += 1.0f;
+        }
+    }
+}
+
+// Largest cell value of a grid, used to normalize density coloring
+float grid_max(const float *grid, size_t cells) {
+    float max_v = 0.0f;
+    #pragma acc parallel loop present(grid) reduction(max:max_v)
+    for (size_t i = 0; i < cells; i++) {
+        if (grid[i] > max_v) max_v = grid[i];
+    }
+    return max_v;
+}
+
+// Follow target bounds: grow immediately so particles are never clipped,
+// shrink slowly so the grid doesn't jitter with the sample from frame to frame
+void track_bounds(Bounds *b, Bounds target, float rate) {
+    b->min_x = (target.min_x < b->min_x) ? target.min_x : b->min_x + (target.min_x - b->min_x) * rate;
+    b->min_y = (target.min_y < b->min_y) ? target.min_y : b->min_y + (target.min_y - b->min_y) * rate;
+    b->min_z = (target.min_z < b->min_z) ? target.min_z : b->min_z + (target.min_z - b->min_z) * rate;
+    b->max_x = (target.max_x > b->max_x) ? target.max_x : b->max_x + (target.max_x - b->max_x) * rate;
+    b->max_y = (target.max_y > b->max_y) ? target.max_y : b->max_y + (target.max_y - b->max_y) * rate;
+    b->max_z = (target.max_z > b->max_z) ? target.max_z : b->max_z + (target.max_z - b->max_z) * rate;
+}
+
+// --- Volumetric Render ---
+// Bin particle counts and summed speeds into two res^3 grids for the ray marcher
+void splat_emission_grid(const float *x, const float *y, const float *z,
+                         const float *vx, const float *vy, const float *vz, int n,
+                         float *density, float *speed, int res, Bounds b) {
+    size_t cells = (size_t)res * res * res;
+    #pragma acc parallel loop present(density, speed)
+    for (size_t i = 0; i < cells; i++) { density[i] = 0.0f; speed[i] = 0.0f; }
+
+    float min_x = b.min_x, min_y = b.min_y, min_z = b.min_z;
+    float sx = res / (b.max_x - b.min_x);
+    float sy = res / (b.max_y - b.min_y);
+    float sz = res / (b.max_z - b.min_z);
+
+    #pragma acc parallel loop present(x, y, z, vx, vy, vz, density, speed)
+    for (int i = 0; i < n; i++) {
+        float fx = (x[i] - min_x) * sx;
+        float fy = (y[i] - min_y) * sy;
+        float fz = (z[i] - min_z) * sz;
+        if (fx >= 0.0f && fx < res && fy >= 0.0f && fy < res && fz >= 0.0f && fz < res) {
+            size_t idx = ((size_t)(int)fz * res + (int)fy) * res + (int)fx;
+            float spd = sqrtf(vx[i]*vx[i] + vy[i]*vy[i] + vz[i]*vz[i]);
+            #pragma acc atomic update
+            density[idx] += 1.0f;
+            #pragma acc atomic update
+            speed[idx] += spd;
+        }
+    }
+}
+
+// Trilinear fetch at continuous cell coordinates (cell centers at +0.5)
+#pragma acc routine seq
+float sample_grid(const float *grid, int res, float fx, float fy, float fz) {
+    fx -= 0.5f; fy -= 0.5f; fz -= 0.5f;
+    if (fx < 0.0f) fx = 0.0f; if (fx > res - 1.001f) fx = res - 1.001f;
+    if (fy < 0.0f) fy = 0.0f; if (fy > res - 1.001f) fy = res - 1.001f;
+    if (fz < 0.0f) fz = 0.0f; if (fz > res - 1.001f) fz = res - 1.001f;
+    int ix = (int)fx, iy = (int)fy, iz = (int)fz;
+    float tx = fx - ix, ty = fy - iy, tz = fz - iz;
+
+    size_t i000 = ((size_t)iz * res + iy) * res + ix;
+    size_t plane = (size_t)res * res;
+    float c00 = grid[i000] + (grid[i000 + 1] - grid[i000]) * tx;
+    float c10 = grid[i000 + res] + (grid[i000 + res + 1] - grid[i000 + res]) * tx;
+    float c01 = grid[i000 + plane] + (grid[i000 + plane + 1] - grid[i000 + plane]) * tx;
+    float c11 = grid[i000 + plane + res] + (grid[i000 + plane + res + 1] - grid[i000 + plane + res]) * tx;
+    float c0 = c00 + (c10 - c00) * ty;
+    float c1 = c01 + (c11 - c01) * ty;
+    return c0 + (c1 - c0) * tz;
+}
+
+// Front-to-back emission/absorption march, one orthographic ray per pixel along
+// rotated z. Density is converted to particles per pixel per unit length, so
+// with zero absorption the image matches point splatting, only smoother.
+// Cost depends on resolution and steps, not on particle count.
+void raymarch_volume(const float *density, const float *speed, int res, Bounds b, float *accum, int width, int height,
+                     float cos_t, float sin_t, float cam_cx, float cam_cy, float cam_scale,
+                     float smooth_max_spd, int steps, float absorption) {
+    float min_x = b.min_x, min_y = b.min_y, min_z = b.min_z;
+    float sx = res / (b.max_x - b.min_x);
+    float sy = res / (b.max_y - b.min_y);
+    float sz = res / (b.max_z - b.min_z);
+    float cell_volume = 1.0f / (sx * sy * sz);
+    float density_scale = 1.0f / (cell_volume * cam_scale * cam_scale);
+
+    // Ray depth span: the bounding sphere of the grid around its rotated center
+    float cx = 0.5f * (b.min_x + b.max_x), cz = 0.5f * (b.min_z + b.max_z);
+    float ex = b.max_x - b.min_x, ey = b.max_y - b.min_y, ez = b.max_z - b.min_z;
+    float radius = 0.5f * sqrtf(ex*ex + ey*ey + ez*ez);
+    float rz_start = cx * sin_t + cz * cos_t - radius;
+    float ds = 2.0f * radius / steps;
+
+    #pragma acc parallel loop collapse(2) present(density, speed, accum)
+    for (int py = 0; py < height; py++) {
+        for (int px = 0; px < width; px++) {
+            float rx = (px + 0.5f - width / 2) / cam_scale + cam_cx;
+            float ry = (py + 0.5f - height / 2) / cam_scale + cam_cy;
+            float fy = (ry - min_y) * sy;
+            float L_r = 0.0f, L_g = 0.0f, L_b = 0.0f, T = 1.0f;
+
+            if (fy >= 0.0f && fy < res) {
+                for (int s = 0; s < steps && T > 0.01f; s++) {
+                    float rz = rz_start + (s + 0.5f) * ds;
+                    float fx = (rx * cos_t + rz * sin_t - min_x) * sx;
+                    float fz = (-rx * sin_t + rz * cos_t - min_z) * sz;
+                    if (fx < 0.0f || fx >= res || fz < 0.0f || fz >= res) continue;
+
+                    float d = sample_grid(density, res, fx, fy, fz);
+                    if (d <= 0.0f) continue;
+                    float spd = sample_grid(speed, res, fx, fy, fz) / d;
+
+                    float r, g, bl;
+                    get_heatmap_color(spd / smooth_max_spd, &r, &g, &bl);
+                    float depth_fade = 1.0f / (1.0f + fabsf(rz) * 0.01f);
+                    float e = d * density_scale * ds;
+                    L_r += T * r * e * depth_fade;
+                    L_g += T * g * e * depth_fade;
+                    L_b += T * bl * e * depth_fade;
+                    T *= expf(-absorption * e);
+                }
+            }
+
+            int idx = (py * width + px) * 3;
+            accum[idx+0] = L_r;
+            accum[idx+1] = L_g;
+            accum[idx+2] = L_b;
+        }
+    }
+}
+
+// --- Trail Render ---
+// Rasterize each particle's trail as segments between consecutive history
+// slots (newest first). Intensity fades linearly with age and each segment's
+// weight is spread over its pixels like motion blur, so a particle with K
+// slots deposits roughly K point splats of energy. Color comes from segment
+// length, i.e. the particle's speed at that point in its history.
+void render_trails(const int16_t *tx, const int16_t *ty, const int16_t *tz, int n, int len, int head,
+                   float *accum, int width, int height, float cos_t, float sin_t, float cam_cx, float cam_cy,
+                   float cam_scale, float smooth_max_spd) {
+    float dq = 1.0f / TRAIL_QUANT;
+    float speed_scale = 1.0f / (DT * smooth_max_spd);
+
+    #pragma acc parallel loop present(tx, ty, tz, accum)
+    for (int i = 0; i < n; i++) {
+        int slot = head;
+        size_t idx0 = (size_t)slot * n + i;
+        float x0 = tx[idx0] * dq, y0 = ty[idx0] * dq, z0 = tz[idx0] * dq;
+
+        for (int age = 1; age < len; age++) {
+            slot = (slot == 0) ? len - 1 : slot - 1;
+            size_t idx1 = (size_t)slot * n + i;
+            float x1 = tx[idx1] * dq, y1 = ty[idx1] * dq, z1 = tz[idx1] * dq;
+
+            float ddx = x1 - x0, ddy = y1 - y0, ddz = z1 - z0;
+            float r, g, b;
+            get_heatmap_color(sqrtf(ddx*ddx + ddy*ddy + ddz*ddz) * speed_scale, &r, &g, &b);
+
+            float sx0 = ((x0 * cos_t - z0 * sin_t) - cam_cx) * cam_scale + width / 2;
+            float sy0 = (y0 - cam_cy) * cam_scale + height / 2;
+            float sx1 = ((x1 * cos_t - z1 * sin_t) - cam_cx) * cam_scale + width / 2;
+            float sy1 = (y1 - cam_cy) * cam_scale + height / 2;
+            float rz = 0.5f * ((x0 + x1) * sin_t + (z0 + z1) * cos_t);
+
+            float span = fmaxf(fabsf(sx1 - sx0), fabsf(sy1 - sy0));
+            int steps = (int)span + 1;
+            if (steps > TRAIL_MAX_STEPS) steps = TRAIL_MAX_STEPS;
+            float fade = (1.0f - (float)(age - 1) / (len - 1)) / (1.0f + fabsf(rz) * 0.01f);
+            float w = fade / steps;
+
+            for (int s = 0; s < steps; s++) {
+                float u = (s + 0.5f) / steps;
+                int px = (int)(sx0 + (sx1 - sx0) * u);
+                int py = (int)(sy0 + (sy1 - sy0) * u);
+                if (px >= 0 && px < width && py >= 0 && py < height) {
+                    int idx = (py * width + px) * 3;
+                    #pragma acc atomic update
+                    accum[idx+0] += r * w;
+                    #pragma acc atomic update
+                    accum[idx+1] += g * w;
+                    #pragma acc atomic update
+                    accum[idx+2] += b * w;
+                }
+            }
+            x0 = x1; y0 = y1; z0 = z1;
+        }
+    }
+}
+
+// ATVOL file header. Dense volumes follow it with res^3 floats (x fastest);
+// sparse volumes with brick_count records of {uint16 bx, by, bz, pad; float[8^3]}.
+// Values are mean particles per cell per frame.
+typedef struct {
+    char magic[8];          // "ATVOL01"
+    int32_t res;            // Cells per axis
+    int32_t sparse;         // 0 = dense, 1 = 8^3 bricks
+    int32_t brick_count;    // Occupied bricks (sparse only)
+    int32_t first_frame;    // First frame accumulated
+    int32_t num_frames;     // Frames accumulated
+    float bounds[6];        // World-space min xyz, max xyz
+} VolumeHeader;
+
+#define VOLUME_BRICK 8
+
+int write_density_volume(const char *path, float *grid, int res, Bounds b,
+                         int first_frame, int num_frames, int sparse) {
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        fprintf(stderr, "Warning: Could not open volume file '%s' for writing\n", path);
+        return -1;
+    }
+
+    size_t cells = (size_t)res * res * res;
+    float norm = 1.0f / num_frames;
+    for (size_t i = 0; i < cells; i++) grid[i] *= norm;
+
+    int bricks = res / VOLUME_BRICK;
+    VolumeHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, "ATVOL01", 8);
+    h.res = res;
+    h.sparse = sparse;
+    h.first_frame = first_frame;
+    h.num_frames = num_frames;
+    h.bounds[0] = b.min_x; h.bounds[1] = b.min_y; h.bounds[2] = b.min_z;
+    h.bounds[3] = b.max_x; h.bounds[4] = b.max_y; h.bounds[5] = b.max_z;
+
+    if (!sparse) {
+        fwrite(&h, sizeof(h), 1, f);
+        fwrite(grid, sizeof(float), cells, f);
+        fclose(f);
+        return 0;
+    }
+
+    // Two passes over the bricks: count occupied ones for the header, then write them
+    float brick[VOLUME_BRICK * VOLUME_BRICK * VOLUME_BRICK];
+    for (int pass = 0; pass < 2; pass++) {
+        if (pass == 1) fwrite(&h, sizeof(h), 1, f);
+        for (int bz = 0; bz < bricks; bz++)
+        for (int by = 0; by < bricks; by++)
+        for (int bx = 0; bx < bricks; bx++) {
+            int occupied = 0, k = 0;
+            for (int z = 0; z < VOLUME_BRICK; z++)
+            for (int y = 0; y < VOLUME_BRICK; y++) {
+                const float *row = grid + ((size_t)(bz * VOLUME_BRICK + z) * res + by * VOLUME_BRICK + y) * res
+                                        + bx * VOLUME_BRICK;
+                for (int x = 0; x < VOLUME_BRICK; x++, k++) {
+                    brick[k] = row[x];
+                    if (row[x] != 0.0f) occupied = 1;
+                }
+            }
+            if (!occupied) continue;
+            if (pass == 0) {
+                h.brick_count++;
+            } else {
+                uint16_t coord[4] = { (uint16_t)bx, (uint16_t)by, (uint16_t)bz, 0 };
+                fwrite(coord, sizeof(uint16_t), 4, f);
+                fwrite(brick, sizeof(float), k, f);
+            }
+        }
+    }
+
+    fclose(f);
+    return 0;
+}
+
+// --- Denoiser ---
+// Joint bilateral filter on the linear accumulation buffer. The range term
+// compares log luminance (what the tone mapper shows) of a 3x3 box-prefiltered
+// guide: isolated speckles in sparse regions blur into their surroundings
+// instead of reading as edges, while dense filaments keep their borders.
+// Normalized weights preserve local energy.
+void denoise_bilateral(const float *accum, float *guide, float *out, int width, int height,
+                       int radius, float sigma_s, float sigma_r) {
+    #pragma acc parallel loop collapse(2) present(accum, guide)
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            float sum = 0.0f;
+            for (int dy = -1; dy <= 1; dy++) {
+                int yy = y + dy < 0 ? 0 : (y + dy >= height ? height - 1 : y + dy);
+                for (int dx = -1; dx <= 1; dx++) {
+                    int xx = x + dx < 0 ? 0 : (x + dx >= width ? width - 1 : x + dx);
+                    const float *c = &accum[((size_t)yy * width + xx) * 3];
+                    sum += 0.2126f * c[0] + 0.7152f * c[1] + 0.0722f * c[2];
+                }
+            }
+            guide[(size_t)y * width + x] = logf(1.0f + sum * (EXPOSURE / 9.0f));
+        }
+    }
+
+    // Spatial weights are the same for every pixel; precompute the (2r+1)^2 table
+    int taps = 2 * radius + 1;
+    float ws[(2 * DENOISE_MAX_RADIUS + 1) * (2 * DENOISE_MAX_RADIUS + 1)];
+    for (int dy = -radius; dy <= radius; dy++)
+        for (int dx = -radius; dx <= radius; dx++)
+            ws[(dy + radius) * taps + dx + radius] = expf(-(dx*dx + dy*dy) / (2.0f * sigma_s * sigma_s));
+
+    // Range weights from a small table instead of an expf per tap
+    float wr[DENOISE_RANGE_LUT];
+    float lut_scale = DENOISE_RANGE_LUT / (3.0f * sigma_r);
+    for (int k = 0; k < DENOISE_RANGE_LUT; k++) {
+        float dg = (k + 0.5f) / lut_scale;
+        wr[k] = expf(-dg * dg / (2.0f * sigma_r * sigma_r));
+    }
+
+    // One gang per tile, one vector lane per pixel: neighbouring lanes read
+    // neighbouring pixels, and a tile plus its halo stays cache resident
+    int tiles_x = (width + DENOISE_TILE - 1) / DENOISE_TILE;
+    int tiles_y = (height + DENOISE_TILE - 1) / DENOISE_TILE;
+    #pragma acc parallel loop gang collapse(2) present(accum, guide, out) copyin(ws[0:taps*taps], wr[0:DENOISE_RANGE_LUT])
+    for (int ty = 0; ty < tiles_y; ty++) {
+        for (int tx = 0; tx < tiles_x; tx++) {
+            #pragma acc loop vector collapse(2)
+            for (int ly = 0; ly < DENOISE_TILE; ly++) {
+                for (int lx = 0; lx < DENOISE_TILE; lx++) {
+                    int x = tx * DENOISE_TILE + lx, y = ty * DENOISE_TILE + ly;
+                    if (x >= width || y >= height) continue;
+                    float gc = guide[(size_t)y * width + x];
+                    size_t o = ((size_t)y * width + x) * 3;
+                    if (gc == 0.0f) {
+                        // Empty 3x3 neighbourhood: keep the background black
+                        out[o + 0] = out[o + 1] = out[o + 2] = 0.0f;
+                        continue;
+                    }
+                    float sr = 0.0f, sg = 0.0f, sb = 0.0f, sw = 0.0f;
+                    for (int dy = -radius; dy <= radius; dy++) {
+                        int yy = y + dy;
+                        if (yy < 0 || yy >= height) continue;
+                        for (int dx = -radius; dx <= radius; dx++) {
+                            int xx = x + dx;
+                            if (xx < 0 || xx >= width) continue;
+                            size_t q = (size_t)yy * width + xx;
+                            int k = (int)(fabsf(guide[q] - gc) * lut_scale);
+                            if (k >= DENOISE_RANGE_LUT) continue;
+                            float w = ws[(dy + radius) * taps + dx + radius] * wr[k];
+                            sr += w * accum[q * 3 + 0];
+                            sg += w * accum[q * 3 + 1];
+                            sb += w * accum[q * 3 + 2];
+                            sw += w;
+                        }
+                    }
+                    float inv = 1.0f / sw;  // The center tap always contributes
+                    out[o + 0] = sr * inv; out[o + 1] = sg * inv; out[o + 2] = sb * inv;
+                }
+            }
+        }
+    }
+}
+
+// No-reference noise estimate of the tone-mapped frame: RMS of each lit
+// pixel's luma minus the mean of its 4 neighbours (8-bit units). Compare runs
+// of the same scene, e.g. 2M particles raw vs 500K denoised.
+float measure_noise(const unsigned char *rgb, int width, int height) {
+    double sum = 0.0;
+    long count = 0;
+    #pragma acc parallel loop collapse(2) present(rgb) reduction(+:sum, count)
+    for (int y = 1; y < height - 1; y++) {
+        for (int x = 1; x < width - 1; x++) {
+            size_t i = ((size_t)y * width + x) * 3;
+            size_t row = (size_t)width * 3;
+            float c = 0.299f * rgb[i] + 0.587f * rgb[i+1] + 0.114f * rgb[i+2];
+            if (c < 2.0f) continue;  // Background is not noise
+            float l = 0.299f * rgb[i-3] + 0.587f * rgb[i-2] + 0.114f * rgb[i-1];
+            float r = 0.299f * rgb[i+3] + 0.587f * rgb[i+4] + 0.114f * rgb[i+5];
+            float u = 0.299f * rgb[i-row] + 0.587f * rgb[i-row+1] + 0.114f * rgb[i-row+2];
+            float d = 0.299f * rgb[i+row] + 0.587f * rgb[i+row+1] + 0.114f * rgb[i+row+2];
+            float hp = c - 0.25f * (l + r + u + d);
+            sum += hp * hp;
+            count++;
+        }
+    }
+    return count > 0 ? (float)sqrt(sum / count) : 0.0f;
+}
+
+// --- Temporal Accumulation ---
+// Camera state needed to carry a pixel from one frame to the next
+typedef struct {
+    float theta, cx, cy, scale;
+} ViewState;
+
+// Blend this frame's splats into a per-pixel running mean carried over from
+// the previous frame. The camera is an orthographic orbit about Y, so a pixel
+// moves with its view depth: each pixel is rotated back by the theta delta at
+// its radiance-weighted depth (or the history's, where this frame is empty),
+// projected with the previous zoom and centre, and the old history is sampled
+// bilinearly there. History is dropped where the neighbourhood disagrees by
+// more than `reject` in log luminance (structure moved in or out), and its
+// length is capped at `cap` frames (0 on a type switch). accum is replaced by
+// mean * max_n, so brightness matches max_n frames of splats.
+void temporal_resolve(float *accum, const float *depth_sum,
+                      const float *hist_rgb, const float *hist_n, const float *hist_depth,
+                      float *next_rgb, float *next_n, float *next_depth, int width, int height,
+                      ViewState prev, ViewState cur, int max_n, int cap, float reject) {
+    float d = cur.theta - prev.theta;
+    float cd = cosf(d), sd = sinf(d);
+    reject = expf(reject);
+    float inv_scale = 1.0f / cur.scale;
+
+    #pragma acc parallel loop collapse(2) present(accum, depth_sum, hist_rgb, hist_n, hist_depth, \
+                                                 next_rgb, next_n, next_depth)
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            size_t i = (size_t)y * width + x;
+
+            float cr = accum[i * 3 + 0], cg = accum[i * 3 + 1], cb = accum[i * 3 + 2];
+            float sum = cr + cg + cb;
+            float depth = sum > 0.0f ? depth_sum[i] / sum : hist_depth[i];
+
+            // Back to the previous frame's screen (pixel-centre coordinates)
+            float rx = (x + 0.5f - width / 2) * inv_scale + cur.cx;
+            float ry = (y + 0.5f - height / 2) * inv_scale + cur.cy;
+            float rx_p = rx * cd + depth * sd;
+            float qx = (rx_p - prev.cx) * prev.scale + width / 2 - 0.5f;
+            float qy = (ry - prev.cy) * prev.scale + height / 2 - 0.5f;
+
+            int x0 = (int)floorf(qx), y0 = (int)floorf(qy);
+            float fx = qx - x0, fy = qy - y0;
+            float hr = 0.0f, hg = 0.0f, hb = 0.0f, hn = 0.0f, hd = 0.0f, hw = 0.0f;
+            for (int k = 0; k < 4; k++) {
+                int sx = x0 + (k & 1), sy = y0 + (k >> 1);
+                if (sx < 0 || sx >= width || sy < 0 || sy >= height) continue;
+                float w = ((k & 1) ? fx : 1.0f - fx) * ((k >> 1) ? fy : 1.0f - fy);
+                size_t q = (size_t)sy * width + sx;
+                hr += w * hist_rgb[q * 3 + 0];
+                hg += w * hist_rgb[q * 3 + 1];
+                hb += w * hist_rgb[q * 3 + 2];
+                hn += w * hist_n[q];
+                hd += w * hist_depth[q];
+                hw += w;
+            }
+            if (hw < 0.5f) hn = 0.0f;  // Mostly off the previous screen
+            else { float inv = 1.0f / hw; hr *= inv; hg *= inv; hb *= inv; hn *= inv; hd *= inv; }
+
+            // Black history under an empty pixel has nothing to reject
+            if (hn > 0.0f && hr + hg + hb + sum > 0.0f) {
+                // Current 3x3 neighbourhood (mean and max luminance) for rejection
+                float mean = 0.0f, peak = 0.0f;
+                for (int dy = -1; dy <= 1; dy++) {
+                    int yy = y + dy < 0 ? 0 : (y + dy >= height ? height - 1 : y + dy);
+                    for (int dx = -1; dx <= 1; dx++) {
+                        int xx = x + dx < 0 ? 0 : (x + dx >= width ? width - 1 : x + dx);
+                        const float *c = &accum[((size_t)yy * width + xx) * 3];
+                        float l = 0.2126f * c[0] + 0.7152f * c[1] + 0.0722f * c[2];
+                        mean += l;
+                        peak = fmaxf(peak, l);
+                    }
+                }
+                mean *= 1.0f / 9.0f;
+                // Log-luminance gaps compared as ratios of (1 + EXPOSURE * l)
+                float th = 1.0f + EXPOSURE * (0.2126f * hr + 0.7152f * hg + 0.0722f * hb);
+                if (th > (1.0f + EXPOSURE * peak) * reject || 1.0f + EXPOSURE * mean > th * reject) hn = 0.0f;
+            }
+
+            float n = fminf(hn, (float)cap) + 1.0f;
+            if (n > max_n) n = max_n;
+            float inv_n = 1.0f / n;
+            hr += (cr - hr) * inv_n;
+            hg += (cg - hg) * inv_n;
+            hb += (cb - hb) * inv_n;
+            // Flush the decaying tail to zero: it is far below one output level
+            // and would otherwise sink into slow denormals
+            if (hr + hg + hb < 1e-4f) hr = hg = hb = 0.0f;
+
+            next_rgb[i * 3 + 0] = hr; next_rgb[i * 3 + 1] = hg; next_rgb[i * 3 + 2] = hb;
+            next_n[i] = n;
+            next_depth[i] = sum > 0.0f ? depth : (hn > 0.0f ? hd : 0.0f);
+        }
+    }
+
+    // Separate pass: the loop above still reads accum's neighbours
+    #pragma acc parallel loop present(accum, next_rgb)
+    for (size_t i = 0; i < (size_t)width * height * 3; i++) accum[i] = next_rgb[i] * max_n;
+}
+
+// --- Background Writer ---
+// Exports are handed to a single writer thread through a bounded queue so disk
+// I/O never runs on the frame thread. Each job owns its data buffer.
+#define WRITE_VOLUME 0
+#define WRITE_PLY 1
+#define WRITE_TIFF_TILE 2
+#define WRITER_QUEUE_SIZE 4
+
+typedef struct TiffFile TiffFile;
+
+typedef struct {
+    int kind;               // WRITE_VOLUME, WRITE_PLY or WRITE_TIFF_TILE
+    char path[512];
+    float *data;            // Volume grid, or x/y/z/speed per point
+    size_t count;           // Points (PLY only)
+    int frame;              // First frame (volume), snapshot frame (PLY) or tile index (TIFF)
+    int num_frames;         // Frames accumulated (volume only)
+    int res, sparse;        // Grid layout (volume only)
+    int type;               // Attractor type at snapshot (PLY only)
+    Bounds bounds;          // World bounds (volume only)
+    TiffFile *tiff;         // Open file (TIFF tile only)
+    unsigned char *pixels;  // Padded RGB tile (TIFF tile only)
+} WriteJob;
+
+// One writer thread shared by every context that exports; started by the first
+// user and joined when the last one stops
+static struct {
+    WriteJob jobs[WRITER_QUEUE_SIZE];
+    int head, count, running, busy, users;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty, not_full, idle;
+    pthread_t thread;
+} writer = { .lock = PTHREAD_MUTEX_INITIALIZER, .not_empty = PTHREAD_COND_INITIALIZER,
+             .not_full = PTHREAD_COND_INITIALIZER, .idle = PTHREAD_COND_INITIALIZER };
+
+int write_ply(const char *path, const float *points, size_t count, int frame, int type) {
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        fprintf(stderr, "Warning: Could not open point cloud file '%s' for writing\n", path);
+        return -1;
+    }
+
+    fprintf(f, "ply\nformat binary_little_endian 1.0\n");
+    fprintf(f, "comment attractor_cinematic frame %d %s\n", frame, ATTRACTOR_NAMES[type]);
+    fprintf(f, "element vertex %zu\n", count);
+    fprintf(f, "property float x\nproperty float y\nproperty float z\nproperty float speed\n");
+    fprintf(f, "end_header\n");
+    fwrite(points, sizeof(float) * 4, count, f);
+    fclose(f);
+    return 0;
+}
+
+// --- Tiled TIFF ---
+// Uncompressed 8-bit RGB, written tile by tile in row-major tile order as the
+// tiles arrive; the directory goes at the end, once every offset is known.
+// BigTIFF (64-bit offsets) when the file would not fit classic TIFF's 4 GB.
+struct TiffFile {
+    FILE *f;
+    int big, ok;
+    int width, height, tile, num_tiles;
+    uint64_t *offsets;
+};
+
+static void put_le(FILE *f, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) fputc((int)((value >> (8 * i)) & 0xFF), f);
+}
+
+static TiffFile *tiff_open(const char *path, int width, int height, int tile) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return NULL;
+    TiffFile *t = (TiffFile*)calloc(1, sizeof(TiffFile));
+    int num_tiles = ((width + tile - 1) / tile) * ((height + tile - 1) / tile);
+    uint64_t *offsets = (uint64_t*)calloc(num_tiles, sizeof(uint64_t));
+    if (!t || !offsets) {
+        free(t);
+        free(offsets);
+        fclose(f);
+        return NULL;
+    }
+    t->f = f;
+    t->ok = 1;
+    t->width = width; t->height = height; t->tile = tile;
+    t->num_tiles = num_tiles;
+    t->offsets = offsets;
+    uint64_t bytes = (uint64_t)t->num_tiles * tile * tile * 3 + (uint64_t)t->num_tiles * 16 + 4096;
+    t->big = bytes > 0xFFFFFFFFull;
+    // Header; the directory offset is patched in by tiff_close
+    fputs("II", f);
+    if (t->big) {
+        put_le(f, 43, 2); put_le(f, 8, 2); put_le(f, 0, 2); put_le(f, 0, 8);
+    } else {
+        put_le(f, 42, 2); put_le(f, 0, 4);
+    }
+    return t;
+}
+
+static void tiff_write_tile(TiffFile *t, int index, const unsigned char *pixels) {
+    size_t bytes = (size_t)t->tile * t->tile * 3;
+    t->offsets[index] = (uint64_t)ftello(t->f);
+    if (fwrite(pixels, 1, bytes, t->f) != bytes) t->ok = 0;
+}
+
+// Write the directory and close; returns 0 if anything failed
+static int tiff_close(TiffFile *t) {
+    FILE *f = t->f;
+    int word = t->big ? 8 : 4;
+    uint64_t tile_bytes = (uint64_t)t->tile * t->tile * 3;
+    struct { int tag, type; uint64_t count, value; const uint64_t *array; uint64_t at; } e[] = {
+        { 256, 4, 1, (uint64_t)t->width },          // ImageWidth
+        { 257, 4, 1, (uint64_t)t->height },         // ImageLength
+        { 258, 3, 3, 8 },                           // BitsPerSample 8,8,8
+        { 259, 3, 1, 1 },                           // Compression: none
+        { 262, 3, 1, 2 },                           // PhotometricInterpretation: RGB
+        { 277, 3, 1, 3 },                           // SamplesPerPixel
+        { 284, 3, 1, 1 },                           // PlanarConfiguration: interleaved
+        { 322, 4, 1, (uint64_t)t->tile },           // TileWidth
+        { 323, 4, 1, (uint64_t)t->tile },           // TileLength
+        { 324, t->big ? 16 : 4, (uint64_t)t->num_tiles, 0, t->offsets },  // TileOffsets
+        { 325, t->big ? 16 : 4, (uint64_t)t->num_tiles, tile_bytes },     // TileByteCounts
+    };
+    int num_entries = sizeof(e) / sizeof(e[0]);
+
+    // Values that do not fit in an entry go ahead of the directory
+    for (int k = 0; k < num_entries; k++) {
+        int size = (e[k].type == 3) ? 2 : (e[k].type == 4) ? 4 : 8;
+        if (e[k].count * size <= (uint64_t)word) continue;
+        e[k].at = (uint64_t)ftello(f);
+        for (uint64_t j = 0; j < e[k].count; j++) put_le(f, e[k].array ? e[k].array[j] : e[k].value, size);
+    }
+    if (ftello(f) & 1) fputc(0, f);  // Directory starts on a word boundary
+    uint64_t ifd = (uint64_t)ftello(f);
+    put_le(f, (uint64_t)num_entries, t->big ? 8 : 2);
+    for (int k = 0; k < num_entries; k++) {
+        int size = (e[k].type == 3) ? 2 : (e[k].type == 4) ? 4 : 8;
+        put_le(f, (uint64_t)e[k].tag, 2);
+        put_le(f, (uint64_t)e[k].type, 2);
+        put_le(f, e[k].count, word);
+        if (e[k].count * size > (uint64_t)word) {
+            put_le(f, e[k].at, word);
+        } else {
+            int used = 0;
+            for (uint64_t j = 0; j < e[k].count; j++, used += size) {
+                put_le(f, e[k].array ? e[k].array[j] : e[k].value, size);
+            }
+            put_le(f, 0, word - used);
+        }
+    }
+    put_le(f, 0, word);  // No next directory
+
+    fseeko(f, t->big ? 8 : 4, SEEK_SET);
+    put_le(f, ifd, word);
+    int ok = t->ok && !ferror(f);
+    ok = (fclose(f) == 0) && ok;
+    free(t->offsets);
+    free(t);
+    return ok;
+}
+
+static void *writer_main(void *arg) {
+    (void)arg;
+    for (;;) {
+        pthread_mutex_lock(&writer.lock);
+        while (writer.count == 0 && writer.running) pthread_cond_wait(&writer.not_empty, &writer.lock);
+        if (writer.count == 0) {
+            pthread_mutex_unlock(&writer.lock);
+            break;
+        }
+        WriteJob job = writer.jobs[writer.head];
+        writer.head = (writer.head + 1) % WRITER_QUEUE_SIZE;
+        writer.count--;
+        writer.busy = 1;
+        pthread_cond_signal(&writer.not_full);
+        pthread_mutex_unlock(&writer.lock);
+
+        if (job.kind == WRITE_VOLUME) {
+            write_density_volume(job.path, job.data, job.res, job.bounds, job.frame, job.num_frames, job.sparse);
+        } else if (job.kind == WRITE_PLY) {
+            write_ply(job.path, job.data, job.count, job.frame, job.type);
+        } else {
+            tiff_write_tile(job.tiff, job.frame, job.pixels);
+        }
+        free(job.data);
+        free(job.pixels);
+
+        pthread_mutex_lock(&writer.lock);
+        writer.busy = 0;
+        if (writer.count == 0) pthread_cond_broadcast(&writer.idle);
+        pthread_mutex_unlock(&writer.lock);
+    }
+    return NULL;
+}
+
+void writer_start(void) {
+    pthread_mutex_lock(&writer.lock);
+    if (writer.users++ == 0) {
+        writer.head = writer.count = 0;
+        writer.running = 1;
+        pthread_create(&writer.thread, NULL, writer_main, NULL);
+    }
+    pthread_mutex_unlock(&writer.lock);
+}
+
+// Queue a job; blocks only if the writer has fallen WRITER_QUEUE_SIZE jobs behind
+void writer_submit(const WriteJob *job) {
+    pthread_mutex_lock(&writer.lock);
+    while (writer.count == WRITER_QUEUE_SIZE) pthread_cond_wait(&writer.not_full, &writer.lock);
+    writer.jobs[(writer.head + writer.count) % WRITER_QUEUE_SIZE] = *job;
+    writer.count++;
+    pthread_cond_signal(&writer.not_empty);
+    pthread_mutex_unlock(&writer.lock);
+}
+
+// Wait until every queued job has been written
+void writer_drain(void) {
+    pthread_mutex_lock(&writer.lock);
+    while (writer.count > 0 || writer.busy) pthread_cond_wait(&writer.idle, &writer.lock);
+    pthread_mutex_unlock(&writer.lock);
+}
+
+// Drop one user; the last one drains remaining jobs and joins the writer thread
+void writer_stop(void) {
+    pthread_mutex_lock(&writer.lock);
+    int last = (--writer.users == 0);
+    if (last) {
+        writer.running = 0;
+        pthread_cond_signal(&writer.not_empty);
+    }
+    pthread_mutex_unlock(&writer.lock);
+    if (last) pthread_join(writer.thread, NULL);
+}
+
+// Download the accumulated grid, queue <prefix>_NNNNN.vol and clear it for the next segment
+void export_density_volume(const char *prefix, int index, float *grid, int res, Bounds b,
+                           int first_frame, int num_frames, int sparse) {
+    size_t cells = (size_t)res * res * res;
+    #pragma acc update self(grid[0:cells])
+
+    WriteJob job = { WRITE_VOLUME };
+    snprintf(job.path, sizeof(job.path), "%s_%05d.vol", prefix, index);
+    job.data = (float*)malloc(cells * sizeof(float));
+    memcpy(job.data, grid, cells * sizeof(float));
+    job.frame = first_frame;
+    job.num_frames = num_frames;
+    job.res = res;
+    job.sparse = sparse;
+    job.bounds = b;
+    writer_submit(&job);
+
+    #pragma acc parallel loop present(grid)
+    for (size_t i = 0; i < cells; i++) grid[i] = 0.0f;
+}
+
+// --- Point Cloud Export ---
+// Snapshot the (already downloaded) particle state into a decimated x/y/z/speed
+// buffer and queue it as <prefix>_NNNNN.ply
+void export_point_cloud(const char *prefix, int index, int frame, int type, int n, float keep, int stratified,
+                        const float *h_x, const float *h_y, const float *h_z,
+                        const float *h_vx, const float *h_vy, const float *h_vz) {
+    // Random selection keeps a variable count, so reserve room for every particle
+    size_t capacity = stratified ? (size_t)(n * (double)keep) + 1 : (size_t)n;
+    float *points = (float*)malloc(capacity * 4 * sizeof(float));
+    size_t count = 0;
+
+    if (stratified) {
+        // One jittered pick per stratum of 1/keep consecutive indices
+        double stride = 1.0 / keep;
+        for (size_t s = 0; s < capacity; s++) {
+            size_t i = (size_t)((s + hash_unit((uint32_t)(s ^ (frame * 2654435761U)))) * stride);
+            if (i >= (size_t)n) break;
+            float *pt = points + count++ * 4;
+            pt[0] = h_x[i]; pt[1] = h_y[i]; pt[2] = h_z[i];
+            pt[3] = sqrtf(h_vx[i]*h_vx[i] + h_vy[i]*h_vy[i] + h_vz[i]*h_vz[i]);
+        }
+    } else {
+        for (int i = 0; i < n; i++) {
+            if (keep < 1.0f && hash_unit((uint32_t)i ^ (frame * 2654435761U)) >= keep) continue;
+            float *pt = points + count++ * 4;
+            pt[0] = h_x[i]; pt[1] = h_y[i]; pt[2] = h_z[i];
+            pt[3] = sqrtf(h_vx[i]*h_vx[i] + h_vy[i]*h_vy[i] + h_vz[i]*h_vz[i]);
+        }
+    }
+
+    WriteJob job = { WRITE_PLY };
+    snprintf(job.path, sizeof(job.path), "%s_%05d.ply", prefix, index);
+    job.data = points;
+    job.count = count;
+    job.frame = frame;
+    job.type = type;
+    writer_submit(&job);
+}
+
+// --- Iterated Maps ---
+#pragma acc routine seq
+void map_step(int type, Params p, float x, float y, float *nx, float *ny) {
+    if (type == MAP_CLIFFORD) {
+        *nx = sinf(p.a * y) + p.c * cosf(p.a * x); *ny = sinf(p.b * x) + p.d * cosf(p.b * y);
+    } else if (type == MAP_DEJONG) {
+        *nx = sinf(p.a * y) - cosf(p.b * x); *ny = sinf(p.c * x) - cosf(p.d * y);
+    } else if (type == MAP_HENON) {
+        *nx = 1.0f - p.a * x * x + y; *ny = p.b * x;
+    } else {
+        *nx = p.d * sinf(p.a * x) - sinf(p.b * y); *ny = p.c * cosf(p.a * x) + cosf(p.b * y);
+    }
+}
+
+// Flush a run of merged splats on one pixel
+#pragma acc routine seq
+void flush_splat_run(uint32_t *hits, float *color, int pix, uint32_t run_hits, float run_color) {
+    if (pix < 0) return;
+    #pragma acc atomic update
+    hits[pix] += run_hits;
+    #pragma acc atomic update
+    color[pix] += run_color;
+}
+
+// Iterate every particle `iters` times in registers, splatting each iterate as
+// an integer hit plus a color coordinate (step length / smooth_max_spd).
+// Consecutive iterates landing on the same pixel are merged before the atomic
+// flush, so each splat costs at most one integer and one float atomic.
+// During a transition particles with hash(i) >= blend still run the previous
+// map; particles that just switched skip MAP_WARMUP iterates to settle.
+// The last step is stored in vx/vy so the camera stats see a speed.
+void iterate_maps(float *x, float *y, float *vx, float *vy, int n,
+                  int cur_type, Params cur_p, int prev_type, Params prev_p,
+                  float blend, float prev_blend, int restart, int iters, uint32_t *hits, float *color,
+                  int width, int height, float cam_cx, float cam_cy, float cam_scale, float smooth_max_spd, int frame) {
+    float inv_max_spd = 1.0f / smooth_max_spd;
+
+    #pragma acc parallel loop present(x, y, vx, vy, hits, color)
+    for (int i = 0; i < n; i++) {
+        float h = hash_unit((uint32_t)i);
+        int use_cur = h < blend;
+        int type = use_cur ? cur_type : prev_type;
+        Params p = use_cur ? cur_p : prev_p;
+        int skip = (restart || (h >= prev_blend && h < blend)) ? MAP_WARMUP : 0;
+
+        float px = x[i], py = y[i], sx = 0.0f, sy = 0.0f;
+        int run_pix = -1;
+        uint32_t run_hits = 0;
+        float run_color = 0.0f;
+
+        for (int k = 0; k < iters; k++) {
+            float nx, ny;
+            map_step(type, p, px, py, &nx, &ny);
+            sx = nx - px; sy = ny - py;
+            px = nx; py = ny;
+
+            // Escaped (or NaN): restart near the origin and settle again
+            if (!(fabsf(px) < MAX_COORD && fabsf(py) < MAX_COORD)) {
+                uint32_t seed = (uint32_t)i * 2654435761U + (uint32_t)(frame * iters + k);
+                px = hash_unit(seed) - 0.5f; py = hash_unit(seed ^ 0x9e3779b9U) - 0.5f;
+                sx = sy = 0.0f;
+                skip = k + 1 + MAP_WARMUP;
+                continue;
+            }
+            if (k < skip) continue;
+
+            int sxp = (int)((px - cam_cx) * cam_scale + width / 2);
+            int syp = (int)((py - cam_cy) * cam_scale + height / 2);
+            int pix = (sxp >= 0 && sxp < width && syp >= 0 && syp < height) ? syp * width + sxp : -1;
+            if (pix != run_pix) {
+                flush_splat_run(hits, color, run_pix, run_hits, run_color);
+                run_pix = pix; run_hits = 0; run_color = 0.0f;
+            }
+            if (pix >= 0) {
+                float t = sqrtf(sx*sx + sy*sy) * inv_max_spd;
+                run_hits++;
+                run_color += (t < 1.0f) ? t : 1.0f;
+            }
+        }
+        flush_splat_run(hits, color, run_pix, run_hits, run_color);
+
+        x[i] = px; y[i] = py;
+        vx[i] = sx; vy[i] = sy;
+    }
+}
+
+// --- Chaos-Game IFS ---
+// Transforms plus a 256-entry selection table, passed to the kernel by value.
+// The table turns weighted selection into one lookup, and every transform
+// evaluates the same variation sequence (gated by the system-wide used mask,
+// which is uniform across threads), so the chaos game never diverges within
+// a warp or SIMD batch no matter which transform each lane picked.
+typedef struct {
+    IfsTransform xf[MAX_IFS_TRANSFORMS];
+    uint8_t select[256];
+    int count;
+    int used;                       // Bit per variation used by any transform
+} IfsSystem;
+
+IfsSystem build_ifs_system(const IfsTransform *xf, int count) {
+    IfsSystem sys;
+    memset(&sys, 0, sizeof(sys));
+    sys.count = count;
+    memcpy(sys.xf, xf, count * sizeof(IfsTransform));
+
+    // Non-positive weights select nothing; if none is positive, all are equal
+    float total = 0.0f;
+    for (int t = 0; t < count; t++) total += (xf[t].weight > 0.0f) ? xf[t].weight : 0.0f;
+    int equal = !(total > 0.0f);
+    if (equal) total = (float)count;
+    float cumulative = 0.0f;
+    int slot = 0;
+    for (int t = 0; t < count; t++) {
+        if (equal) cumulative += 1.0f;
+        else if (xf[t].weight > 0.0f) cumulative += xf[t].weight;
+        int end = (t == count - 1) ? 256 : (int)(cumulative / total * 256.0f + 0.5f);
+        for (; slot < end; slot++) sys.select[slot] = (uint8_t)t;
+        for (int v = 0; v < NUM_VARIATIONS; v++) {
+            if (xf[t].var[v] != 0.0f) sys.used |= 1 << v;
+        }
+    }
+    return sys;
+}
+
+// Default system when the config defines none: a swirled Sierpinski gasket
+int default_ifs(IfsTransform *xf) {
+    memset(xf, 0, 3 * sizeof(IfsTransform));
+    xf[0] = (IfsTransform){ 1.0f, 0.5f, 0.0f, -0.5f, 0.0f, 0.5f, -0.5f, 0.0f, { 1.0f } };
+    xf[1] = (IfsTransform){ 1.0f, 0.5f, 0.0f, 0.5f, 0.0f, 0.5f, -0.5f, 0.5f, { 1.0f } };
+    xf[2] = (IfsTransform){ 1.0f, 0.5f, 0.0f, 0.0f, 0.0f, 0.5f, 0.5f, 1.0f, { 0.7f, 0.0f, 0.0f, 0.3f } };
+    return 3;
+}
+
+void log_ifs(FILE *logf, const IfsTransform *xf, int count) {
+    if (!logf) return;
+    fprintf(logf, "00:00 IFS %d transforms\n", count);
+    for (int t = 0; t < count; t++) {
+        fprintf(logf, "      w=%.3f a=%.3f b=%.3f c=%.3f d=%.3f e=%.3f f=%.3f color=%.2f\n",
+                xf[t].weight, xf[t].a, xf[t].b, xf[t].c, xf[t].d, xf[t].e, xf[t].f, xf[t].color);
+    }
+}
+
+// Chaos game: each particle runs `iters` iterations with a per-thread xorshift
+// RNG, splatting each point with its color coordinate (the running average of
+// the chosen transforms' colors, stored between frames in z).
+void iterate_ifs(float *x, float *y, float *c, float *vx, float *vy, int n, IfsSystem sys,
+                 int restart, int iters, uint32_t *hits, float *color, int width, int height,
+                 float cam_cx, float cam_cy, float cam_scale, int frame) {
+    #pragma acc parallel loop present(x, y, c, vx, vy, hits, color)
+    for (int i = 0; i < n; i++) {
+        uint32_t rng = (uint32_t)i * 2654435761U ^ (uint32_t)frame * 0x85ebca6bU;
+        rng = rng ? rng : 1u;
+        float px = x[i], py = y[i], pc = c[i], sx = 0.0f, sy = 0.0f;
+        int skip = restart ? MAP_WARMUP : 0;
+        int run_pix = -1;
+        uint32_t run_hits = 0;
+        float run_color = 0.0f;
+
+        for (int k = 0; k < iters; k++) {
+            rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+            const IfsTransform *xf = &sys.xf[sys.select[rng >> 24]];
+
+            float ax = xf->a * px + xf->b * py + xf->c;
+            float ay = xf->d * px + xf->e * py + xf->f;
+            float r2 = ax * ax + ay * ay + 1e-10f;
+            float nx = 0.0f, ny = 0.0f;
+            if (sys.used & (1 << VAR_LINEAR)) {
+                nx += xf->var[VAR_LINEAR] * ax; ny += xf->var[VAR_LINEAR] * ay;
+            }
+            if (sys.used & (1 << VAR_SINUSOIDAL)) {
+                nx += xf->var[VAR_SINUSOIDAL] * sinf(ax); ny += xf->var[VAR_SINUSOIDAL] * sinf(ay);
+            }
+            if (sys.used & (1 << VAR_SPHERICAL)) {
+                nx += xf->var[VAR_SPHERICAL] * ax / r2; ny += xf->var[VAR_SPHERICAL] * ay / r2;
+            }
+            if (sys.used & (1 << VAR_SWIRL)) {
+                float sr = sinf(r2), cr = cosf(r2);
+                nx += xf->var[VAR_SWIRL] * (ax * sr - ay * cr);
+                ny += xf->var[VAR_SWIRL] * (ax * cr + ay * sr);
+            }
+            if (sys.used & (1 << VAR_HORSESHOE)) {
+                float inv_r = 1.0f / sqrtf(r2);
+                nx += xf->var[VAR_HORSESHOE] * (ax - ay) * (ax + ay) * inv_r;
+                ny += xf->var[VAR_HORSESHOE] * 2.0f * ax * ay * inv_r;
+            }
+            if (sys.used & (1 << VAR_POLAR)) {
+                nx += xf->var[VAR_POLAR] * atan2f(ax, ay) * (1.0f / (float)M_PI);
+                ny += xf->var[VAR_POLAR] * (sqrtf(r2) - 1.0f);
+            }
+            pc = 0.5f * (pc + xf->color);
+            sx = nx - px; sy = ny - py;
+            px = nx; py = ny;
+
+            if (!(fabsf(px) < MAX_COORD && fabsf(py) < MAX_COORD)) {
+                px = hash_unit(rng) * 2.0f - 1.0f; py = hash_unit(rng ^ 0x9e3779b9U) * 2.0f - 1.0f;
+                sx = sy = 0.0f;
+                skip = k + 1 + MAP_WARMUP;
+                continue;
+            }
+            if (k < skip) continue;
+
+            int sxp = (int)((px - cam_cx) * cam_scale + width / 2);
+            int syp = (int)((py - cam_cy) * cam_scale + height / 2);
+            int pix = (sxp >= 0 && sxp < width && syp >= 0 && syp < height) ? syp * width + sxp : -1;
+            if (pix != run_pix) {
+                flush_splat_run(hits, color, run_pix, run_hits, run_color);
+                run_pix = pix; run_hits = 0; run_color = 0.0f;
+            }
+            if (pix >= 0) {
+                run_hits++;
+                run_color += pc;
+            }
+        }
+        flush_splat_run(hits, color, run_pix, run_hits, run_color);
+
+        x[i] = px; y[i] = py; c[i] = pc;
+        vx[i] = sx; vy[i] = sy;
+    }
+}
+
+// Convert hit counts to heatmap RGB in accum_buffer, optionally clearing the
+// hit buffers. Scaling by 1/iters keeps brightness equal to one splat per
+// particle, so the usual EXPOSURE and log tone map apply unchanged.
+void resolve_map_hits(uint32_t *hits, float *color, float *accum, int width, int height, float scale, int clear) {
+    #pragma acc parallel loop present(hits, color, accum)
+    for (int i = 0; i < width * height; i++) {
+        uint32_t h = hits[i];
+        float r = 0.0f, g = 0.0f, b = 0.0f;
+        if (h > 0) {
+            get_heatmap_color(color[i] / h, &r, &g, &b);
+            float w = h * scale;
+            r *= w; g *= w; b *= w;
+        }
+        accum[i*3+0] = r;
+        accum[i*3+1] = g;
+        accum[i*3+2] = b;
+        if (clear) {
+            hits[i] = 0;
+            color[i] = 0.0f;
+        }
+    }
+}
+
+// --- Bifurcation Diagram ---
+// Particle i belongs to column i / per_col, so consecutive particles (a warp
+// or SIMD batch) share one parameter value and take identical branches.
+// Each particle runs `steps` steps of `substeps` Euler substeps through
+// attractor_rhs. When plotting, each step (or each local maximum of the
+// plotted axis) lands at (column, value) in the hit buffers, colored by speed.
+void integrate_bifurcation(float *x, float *y, float *z, float *vx, float *vy, float *vz, int n, int per_col,
+                           int type, Params base, int param, float p_min, float p_step,
+                           int steps, int substeps, int plot, int axis, int maxima, float v_min, float v_scale,
+                           float inv_max_spd, uint32_t *hits, float *color, int width, int height) {
+    float dt = DT / substeps;
+
+    #pragma acc parallel loop present(x, y, z, vx, vy, vz, hits, color)
+    for (int i = 0; i < n; i++) {
+        int col = i / per_col;
+        Params p = base;
+        ((float*)&p)[param] = p_min + col * p_step;
+
+        float px = x[i], py = y[i], pz = z[i], dx = 0.0f, dy = 0.0f, dz = 0.0f;
+        float v1 = 0.0f, v2 = 0.0f;  // Plotted axis one and two steps back
+        int run_pix = -1;
+        uint32_t run_hits = 0;
+        float run_color = 0.0f;
+
+        for (int k = 0; k < steps; k++) {
+            for (int s = 0; s < substeps; s++) {
+                attractor_rhs(type, p, px, py, pz, &dx, &dy, &dz);
+                px += dx * dt; py += dy * dt; pz += dz * dt;
+            }
+            if (!(fabsf(px) < BIF_MAX_COORD && fabsf(py) < BIF_MAX_COORD && fabsf(pz) < BIF_MAX_COORD)) {
+                float hash = hash_unit((uint32_t)i ^ (uint32_t)k * 2654435761U);
+                px = (hash - 0.5f) * 4.0f; py = (0.5f - hash) * 4.0f; pz = hash * 4.0f;
+                dx = dy = dz = 0.0f;
+                v1 = v2 = 0.0f;
+                continue;
+            }
+            if (!plot) continue;
+
+            float v = (axis == 0) ? px : (axis == 1) ? py : pz;
+            float pv = v;
+            int emit = 1;
+            if (maxima) {
+                emit = (k >= 2 && v1 > v2 && v1 >= v);
+                pv = v1;
+            }
+            v2 = v1; v1 = v;
+            if (!emit) continue;
+
+            // Range-checked as a float: the int conversion of far outliers is undefined
+            float fr = (pv - v_min) * v_scale;
+            int pix = (fr > -1.0f && fr < height) ? (height - 1 - (int)fr) * width + col : -1;
+            if (pix != run_pix) {
+                flush_splat_run(hits, color, run_pix, run_hits, run_color);
+                run_pix = pix; run_hits = 0; run_color = 0.0f;
+            }
+            if (pix >= 0) {
+                float t = sqrtf(dx*dx + dy*dy + dz*dz) * inv_max_spd;
+                run_hits++;
+                run_color += (t < 1.0f) ? t : 1.0f;
+            }
+        }
+        flush_splat_run(hits, color, run_pix, run_hits, run_color);
+
+        x[i] = px; y[i] = py; z[i] = pz;
+        vx[i] = dx; vy[i] = dy; vz[i] = dz;
+    }
+}
+
+// --- Parameter-Plane Lyapunov / Basin Map ---
+// Every pixel is an independent (param_x, param_y) pair: one trajectory from a
+// fixed start through attractor_rhs, plus a tangent vector advanced with a
+// finite-difference Jacobian-vector product (two RHS evaluations per step).
+// The tangent is renormalized every step and its log growth averaged into
+// the largest Lyapunov exponent. Writes `rows` rows of RGB starting at row0
+// on async queue `queue`.
+void lyapunov_band(unsigned char *rgb, int width, int row0, int rows, int type, Params base,
+                   int param_x, float x_min, float x_step, int param_y, float y_max, float y_step,
+                   int transient, int steps, int color_mode, float scale, int queue) {
+    float dt = DT;
+
+    #pragma acc parallel loop collapse(2) present(rgb) async(queue)
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < width; c++) {
+            Params p = base;
+            ((float*)&p)[param_x] = x_min + c * x_step;
+            ((float*)&p)[param_y] = y_max - (row0 + r) * y_step;
+
+            float x = 0.1f, y = 0.1f, z = 0.1f, dx = 0.0f, dy = 0.0f, dz = 0.0f;
+            float tx = 1.0f, ty = 0.0f, tz = 0.0f;
+            float log_sum = 0.0f;
+            int diverged = 0;
+
+            for (int k = 0; k < transient + steps && !diverged; k++) {
+                attractor_rhs(type, p, x, y, z, &dx, &dy, &dz);
+                if (k >= transient) {
+                    float eps = 1e-3f * (1.0f + fmaxf(fabsf(x), fmaxf(fabsf(y), fabsf(z))));
+                    float ex, ey, ez;
+                    attractor_rhs(type, p, x + eps * tx, y + eps * ty, z + eps * tz, &ex, &ey, &ez);
+                    tx += (ex - dx) / eps * dt; ty += (ey - dy) / eps * dt; tz += (ez - dz) / eps * dt;
+                    float len = sqrtf(tx*tx + ty*ty + tz*tz);
+                    log_sum += logf(len);
+                    tx /= len; ty /= len; tz /= len;
+                }
+                x += dx * dt; y += dy * dt; z += dz * dt;
+                if (!(fabsf(x) < BIF_MAX_COORD && fabsf(y) < BIF_MAX_COORD && fabsf(z) < BIF_MAX_COORD)) diverged = 1;
+            }
+
+            float cr = 0.0f, cg = 0.0f, cb = 0.0f;
+            if (diverged) {
+                cr = cg = cb = 0.1f;
+            } else if (color_mode == LYAP_BASIN) {
+                // Octant of the final state, dimmed when it settled on a fixed point
+                int octant = (x > 0.0f) | ((y > 0.0f) << 1) | ((z > 0.0f) << 2);
+                get_heatmap_color((octant + 0.5f) / 8.0f, &cr, &cg, &cb);
+                float shade = (sqrtf(dx*dx + dy*dy + dz*dz) < 1e-3f) ? 0.35f : 1.0f;
+                cr *= shade; cg *= shade; cb *= shade;
+            } else {
+                float lambda = log_sum / (steps * dt);
+                if (lambda > 0.0f) {
+                    // Chaotic: heatmap by exponent
+                    get_heatmap_color(lambda / scale, &cr, &cg, &cb);
+                } else {
+                    // Stable / periodic: gold fading toward black as orbits get more attracting
+                    float shade = expf(lambda / scale * 4.0f);
+                    cr = 1.0f * shade; cg = 0.75f * shade; cb = 0.2f * shade;
+                }
+            }
+
+            size_t idx = ((size_t)r * width + c) * 3;
+            rgb[idx+0] = (unsigned char)(cr * 255.0f);
+            rgb[idx+1] = (unsigned char)(cg * 255.0f);
+            rgb[idx+2] = (unsigned char)(cb * 255.0f);
+        }
+    }
+}
+
+// Stream the map to stdout as a binary PPM, one band of rows at a time.
+// Two band buffers on two async queues alternate, so band k+1 computes
+// while band k is downloaded and written.
+int run_lyapunov_map(int type, int width, int height) {
+    int band = cfg_lyap_band;
+    size_t band_bytes = (size_t)width * band * 3;
+    unsigned char *bands = (unsigned char*)malloc(2 * band_bytes);
+    #pragma acc enter data create(bands[0:2*band_bytes])
+
+    uint64_t stream = 0;
+    Params base = get_target_params(type, &stream);  // Fixed stream, so the base is reproducible
+    float x_step = (cfg_lyap_x_max - cfg_lyap_x_min) / (width > 1 ? width - 1 : 1);
+    float y_step = (cfg_lyap_y_max - cfg_lyap_y_min) / (height > 1 ? height - 1 : 1);
+    fprintf(stderr, "Lyapunov map %dx%d: %s, %c=[%.3f,%.3f] x %c=[%.3f,%.3f]\n", width, height,
+            ATTRACTOR_NAMES[type], 'a' + cfg_lyap_param_x, cfg_lyap_x_min, cfg_lyap_x_max,
+            'a' + cfg_lyap_param_y, cfg_lyap_y_min, cfg_lyap_y_max);
+
+    printf("P6\n%d %d\n255\n", width, height);
+    int num_bands = (height + band - 1) / band;
+    for (int k = 0; k <= num_bands; k++) {
+        if (k < num_bands) {
+            unsigned char *next = bands + (k % 2) * band_bytes;
+            int rows = (k * band + band <= height) ? band : height - k * band;
+            lyapunov_band(next, width, k * band, rows, type, base,
+                          cfg_lyap_param_x, cfg_lyap_x_min, x_step, cfg_lyap_param_y, cfg_lyap_y_max, y_step,
+                          cfg_lyap_transient, cfg_lyap_steps, cfg_lyap_color, cfg_lyap_scale, 1 + k % 2);
+        }
+        if (k > 0) {
+            int queue = 1 + (k - 1) % 2;
+            (void)queue;  // Only referenced by the async clauses
+            unsigned char *done = bands + ((k - 1) % 2) * band_bytes;
+            int rows = ((k - 1) * band + band <= height) ? band : height - (k - 1) * band;
+            size_t bytes = (size_t)width * rows * 3;
+            #pragma acc update self(done[0:bytes]) async(queue)
+            #pragma acc wait(queue)
+            fwrite(done, 1, bytes, stdout);
+            fflush(stdout);
+            fprintf(stderr, "Rows %d/%d\r", (k - 1) * band + rows, height);
+        }
+    }
+    fprintf(stderr, "\n");
+
+    #pragma acc exit data delete(bands[0:2*band_bytes])
+    free(bands);
+    return 0;
+}
+
+// --- Framing Calibration ---
+// k-th smallest of a[0..n) (partially reorders a)
+static float select_kth(float *a, int n, int k) {
+    int lo = 0, hi = n - 1;
+    while (lo < hi) {
+        float pivot = a[(lo + hi) / 2];
+        int i = lo, j = hi;
+        while (i <= j) {
+            while (a[i] < pivot) i++;
+            while (a[j] > pivot) j--;
+            if (i <= j) { float t = a[i]; a[i] = a[j]; a[j] = t; i++; j--; }
+        }
+        if (k <= j) hi = j;
+        else if (k >= i) lo = i;
+        else break;
+    }
+    return a[k];
+}
+
+// Find the framing multiplier for each flow type from probe runs. The camera
+// sets scale = min(W, H) * screen_fill / (mean |deviation| * multiplier) per
+// axis, so a multiplier of screen_fill / fill * (extent / deviation) makes
+// the central 99% of the projection span `fill` of the limiting axis. The
+// ratio is measured over orbit angles (and x-w phases for 4D types), over
+// snapshots of each probe, and over randomized parameter draws. Its 90th
+// percentile is used so that few views clip.
+void calibrate_framing(float *mults, uint64_t *stream) {
+    int n = cfg_calibrate_particles;
+    float *px = (float*)malloc(n * sizeof(float)), *py = (float*)malloc(n * sizeof(float));
+    float *pz = (float*)malloc(n * sizeof(float)), *pw = (float*)calloc(n, sizeof(float));
+    float *pvx = (float*)calloc(n, sizeof(float)), *pvy = (float*)calloc(n, sizeof(float));
+    float *pvz = (float*)calloc(n, sizeof(float)), *pvw = (float*)calloc(n, sizeof(float));
+    int16_t trail_stub[1];
+    float *rx = (float*)malloc(n * sizeof(float)), *ry = (float*)malloc(n * sizeof(float));
+    int max_ratios = cfg_calibrate_trials * CALIBRATE_SNAPSHOTS * CALIBRATE_VIEWS * 4;
+    float *ratios = (float*)malloc(max_ratios * sizeof(float));
+    if (!px || !py || !pz || !pw || !pvx || !pvy || !pvz || !pvw || !rx || !ry || !ratios) {
+        fprintf(stderr, "Warning: out of memory for framing calibration, multipliers unchanged\n");
+        free(px); free(py); free(pz); free(pw); free(pvx); free(pvy); free(pvz); free(pvw);
+        free(rx); free(ry); free(ratios);
+        return;
+    }
+    Sampler smp = {SAMPLER_SOBOL, {0, 0, 0}};
+    #pragma acc enter data create(px[0:n], py[0:n], pz[0:n], pw[0:n], pvx[0:n], pvy[0:n], pvz[0:n], pvw[0:n], \
+                                  trail_stub[0:1])
+
+    for (int type = 0; type < NUM_TYPES; type++) {
+        int num_ratios = 0;
+        int phases = (ATTRACTOR_DIMS[type] == 4) ? 4 : 1;
+        for (int trial = 0; trial < cfg_calibrate_trials; trial++) {
+            Group g;
+            memset(&g, 0, sizeof(g));
+            g.end = n;
+            g.id_stride = 1;
+            g.id_count = g.id_total = n;
+            g.type = g.prev_type = type;
+            g.p = get_target_params(type, stream);
+            g.scale = 1.0f;
+            g.dims = ATTRACTOR_DIMS[type];
+            for (int k = 0; k < 3; k++) smp.shift[k] = stream_u32(stream);
+            for (int i = 0; i < n; i++) {
+                float u0, u1, u2;
+                sample_point(smp, (uint32_t)i, &u0, &u1, &u2);
+                px[i] = u0 * 10.0f - 5.0f; py[i] = u1 * 10.0f - 5.0f; pz[i] = u2 * 10.0f - 5.0f;
+                pw[i] = pvx[i] = pvy[i] = pvz[i] = pvw[i] = 0.0f;
+            }
+            #pragma acc update device(px[0:n], py[0:n], pz[0:n], pw[0:n], pvx[0:n], pvy[0:n], pvz[0:n], pvw[0:n])
+
+            for (int step = 0; step < CALIBRATE_WARMUP + CALIBRATE_SNAPSHOTS * CALIBRATE_INTERVAL; step++) {
+                smp.round = (uint32_t)step;
+                if (g.dims == 4) integrate_flow_4d(px, py, pz, pw, pvx, pvy, pvz, pvw, n, g, 1.0f, DT, smp,
+                                                   trail_stub, trail_stub, trail_stub, 0, 0);
+                else integrate_flow_3d(px, py, pz, pvx, pvy, pvz, n, g, 1.0f, DT, smp,
+                                       trail_stub, trail_stub, trail_stub, 0, 0);
+                if (step < CALIBRATE_WARMUP || (step - CALIBRATE_WARMUP) % CALIBRATE_INTERVAL != 0) continue;
+
+                #pragma acc update self(px[0:n], py[0:n], pz[0:n], pw[0:n])
+                for (int v = 0; v < CALIBRATE_VIEWS * phases; v++) {
+                    float theta = (v % CALIBRATE_VIEWS) * (float)M_PI / CALIBRATE_VIEWS;
+                    float phase = (v / CALIBRATE_VIEWS) * 0.25f * (float)M_PI;
+                    float ct = cosf(theta), st = sinf(theta), ch = cosf(phase), sh = sinf(phase);
+                    double sx = 0.0, sy = 0.0;
+                    for (int i = 0; i < n; i++) {
+                        float x = px[i] * ch - pw[i] * sh;
+                        rx[i] = x * ct - pz[i] * st;
+                        ry[i] = py[i];
+                        sx += rx[i]; sy += ry[i];
+                    }
+                    float mx = (float)(sx / n), my = (float)(sy / n);
+                    double dx = 0.0, dy = 0.0;
+                    for (int i = 0; i < n; i++) { dx += fabsf(rx[i] - mx); dy += fabsf(ry[i] - my); }
+                    int lo = n / 200, hi = n - 1 - n / 200;
+                    float ext_x = select_kth(rx, n, hi) - select_kth(rx, n, lo);
+                    float ext_y = select_kth(ry, n, hi) - select_kth(ry, n, lo);
+                    float rx_ratio = ext_x / (float)(dx / n + 1e-6), ry_ratio = ext_y / (float)(dy / n + 1e-6);
+                    ratios[num_ratios++] = (rx_ratio > ry_ratio) ? rx_ratio : ry_ratio;
+                }
+            }
+        }
+        float ratio = select_kth(ratios, num_ratios, (int)(0.9f * (num_ratios - 1)));
+        float was = ATTRACTOR_BASE_MULTIPLIERS[type];
+        mults[type] = cfg_screen_fill_factor / cfg_calibrate_fill * ratio;
+        fprintf(stderr, "Calibrate %-12s extent/deviation %.2f -> multiplier %.3f (was %.3f)\n",
+                ATTRACTOR_NAMES[type], ratio, mults[type], was);
+    }
+
+    #pragma acc exit data delete(px[0:n], py[0:n], pz[0:n], pw[0:n], pvx[0:n], pvy[0:n], pvz[0:n], pvw[0:n], \
+                                 trail_stub[0:1])
+    free(px); free(py); free(pz); free(pw); free(pvx); free(pvy); free(pvz); free(pvw);
+    free(rx); free(ry); free(ratios);
+}
+
+// -m calibrate: write the multipliers as config lines to stdout
+int run_calibration(void) {
+    float mults[NUM_TYPES];
+    memcpy(mults, ATTRACTOR_BASE_MULTIPLIERS, sizeof(mults));
+    uint64_t stream = (uint64_t)time(NULL);
+    calibrate_framing(mults, &stream);
+    printf("# Framing multipliers from %d probe runs of %d particles per type\n",
+           cfg_calibrate_trials, cfg_calibrate_particles);
+    printf("# (attractor spans %.2f of the frame at screen_fill_factor=%.3f)\n",
+           cfg_calibrate_fill, cfg_screen_fill_factor);
+    printf("screen_fill_factor=%.3f\n", cfg_screen_fill_factor);
+    for (int type = 0; type < NUM_TYPES; type++) printf("%s=%.3f\n", ATTRACTOR_CONFIG_KEYS[type], mults[type]);
+    return 0;
+}
+
+
+// --- Context API (libattractor.h) ---
+// Live control: single-producer, single-consumer ring of command lines.
+// ac_post_command fills it from the control thread, ac_step drains it at the
+// start of a frame; neither side ever waits for the other.
+#define COMMAND_QUEUE_SIZE 64
+#define COMMAND_LENGTH 128
+
+typedef struct {
+    char lines[COMMAND_QUEUE_SIZE][COMMAND_LENGTH];
+    atomic_uint head, tail;                 // Next to apply, next to fill
+} CommandQueue;
+
+struct ac_context {
+    int mode, width, height, num_particles, alloc_particles, num_types, frames_per_fragment;
+    uint64_t placement, decisions;          // Host random streams: particle placement, scene decisions
+
+    // Proxy: particle i stands for one particle in id_stride of full_particles, and
+    // the frame is rendered at render_width x render_height, then upscaled
+    int id_stride, full_particles, render_width, render_height;
+    float render_scale, density_comp;
+    float *proxy_accum;                     // Tent-filtered accum (proxy)
+    unsigned char *proxy_rgb;
+    FILE *log_file;
+    char *volume_prefix, *ply_prefix;
+    int writing;                            // Holds a writer thread reference
+
+    // Particle state and render buffers
+    float *h_x, *h_y, *h_z;
+    float *h_vx, *h_vy, *h_vz;
+    float *h_w, *h_vw;                      // Fourth state component (4D types, MODE_FLOW only)
+    float *accum_buffer;
+    unsigned char *out_buffer;
+    float *volume_grid;
+    float *march_density, *march_speed;
+    float *occupancy;
+    uint32_t *map_hits;
+    float *map_color;
+    int16_t *trail_x, *trail_y, *trail_z;
+    float *denoise_guide, *denoise_buffer;
+    float *frame_depth;                     // Per-pixel radiance-weighted view depth (temporal only)
+    float *history_rgb[2], *history_n[2], *history_depth[2];
+    float *speed;                           // Created by the first ac_get_buffers
+    size_t history_cells, w_cells, trail_cells, occ_cells, march_cells, volume_cells;
+
+    // Scene
+    int scene, num_groups;
+    Group groups[MAX_GROUPS];
+    float scene_multiplier;
+    Sampler sampler;
+    IfsTransform ifs_xf[MAX_IFS_TRANSFORMS];
+    int ifs_count;
+    int color_mode;
+    float color_density_mix;
+
+    // Temporal history, double-buffered: read [cur], write [cur ^ 1], swap
+    int temporal, temporal_frames, history_cur;
+    ViewState prev_view;
+
+    // Reduced-rate physics keys
+    int physics_k, interp;
+    float *display[KEY_COMPONENTS], *key0[KEY_COMPONENTS], *key1[KEY_COMPONENTS];
+
+    int trail_len, trail_head;
+    int occ_res;
+    Bounds occ_bounds, march_bounds;
+
+    // Bifurcation columns
+    int bif_per_col;
+    float bif_v_min, bif_v_scale, bif_inv_max_spd;
+    long bif_plotted_steps;
+
+    // Exports
+    Bounds volume_bounds;
+    int volume_accum_frames, volume_first_frame, volume_index, ply_index, ply_requested;
+
+    // Schedule and camera
+    int current_type, previous_type, algo_timer, frame;
+    Params cur_p, target_p, prev_p;
+    float *base_multipliers;
+    float cam_scale, cam_cx, cam_cy, smooth_max_spd, smooth_base_multiplier;
+    float cam_follow;                       // Per-frame smoothing of camera and speed normalization
+    float transition_blend, prev_blend;     // 1.0 = fully current, 0.0 = fully previous
+    float hyper_phase, hyper_spin;
+    int start_type;
+
+    // Live control: operator offsets on top of the automatic camera and tone map
+    CommandQueue commands;
+    int paused;
+    float pan_x, pan_y;                     // Camera target offset, in frame heights
+    float zoom, exposure;                   // Multipliers (1 = automatic)
+
+    // View of the last step, used by ac_render
+    float theta;
+    int hyper_view;
+    float cos_h, sin_h;
+
+    float noise;
+    double noise_total;
+    int frames_rendered;
+};
+
+#define LOG_FRAMERATE 60                    // For chapter timestamps
+
+void ac_default_options(ac_options *opt) {
+    memset(opt, 0, sizeof(*opt));
+    opt->mode = MODE_FLOW;
+    opt->num_particles = NUM_PARTICLES;
+    opt->width = WIDTH;
+    opt->height = HEIGHT;
+    opt->start_type = TYPE_AIZAWA;
+    opt->frames_per_fragment = 300;
+    opt->physics_interval = opt->temporal_frames = -1;
+}
+
+int ac_mode_from_name(const char *name) {
+    for (int m = 0; m < NUM_MODES; m++) {
+        if (strcmp(name, MODE_NAMES[m]) == 0) return m;
+    }
+    return -1;
+}
+
+void ac_load_config(const char *path) {
+    load_config(path);
+}
+
+int ac_configure(const char *key, const char *value) {
+    char line[256];
+    snprintf(line, sizeof(line), "%s=%s", key, value);
+    int known = apply_config_line(line);
+    clamp_config();
+    return known ? 0 : -1;
+}
+
+// Framing multiplier of a layered scene: the groups' type multipliers
+// weighted by share
+static float scene_multiplier(const ac_context *ctx) {
+    float m = 0.0f;
+    for (int g = 0; g < ctx->num_groups; g++) m += ATTRACTOR_BASE_MULTIPLIERS[ctx->groups[g].type] * ctx->groups[g].share;
+    return m;
+}
+
+// Re-read the config file between frames. Changed live keys are validated
+// and then applied together; lines that would need a restart are reported
+// once and ignored. Keys removed from the file keep their current values.
+int ac_reload_config(ac_context *ctx, const char *path) {
+    int count;
+    char **lines = read_config_lines(path, &count);
+    if (!lines) {
+        fprintf(stderr, "\nConfig: could not read '%s', keeping current settings\n", path);
+        return -1;
+    }
+
+    float staged[NUM_LIVE_KEYS];
+    int changed[NUM_LIVE_KEYS] = { 0 };
+    int num_changed = 0, num_rejected = 0;
+    for (int k = 0; k < count; k++) {
+        char key[64];
+        float value;
+        int fields = sscanf(lines[k], " %63[^= ] = %f", key, &value);
+        int live = -1;
+        for (int j = 0; j < NUM_LIVE_KEYS && fields >= 1; j++) {
+            if (strcmp(key, LIVE_KEYS[j].key) == 0) live = j;
+        }
+        if (live < 0) {
+            if (!config_line_seen(lines[k])) {
+                fprintf(stderr, "\nConfig: '%s' takes effect on restart, ignored\n", lines[k]);
+            }
+            continue;
+        }
+        const LiveKey *lk = &LIVE_KEYS[live];
+        if (fields != 2 || !isfinite(value) || value < lk->min || value > lk->max ||
+            (lk->i && value != floorf(value))) {
+            if (!config_line_seen(lines[k])) {
+                fprintf(stderr, "\nConfig: rejected '%s' (%s from %g to %g)\n", lines[k],
+                        lk->i ? "whole number" : "number", lk->min, lk->max);
+                num_rejected++;
+            }
+            continue;
+        }
+        staged[live] = value;
+        changed[live] = lk->i ? (*lk->i != (int)value) : (*lk->f != value);
+    }
+
+    // Cross-key check on the values the frame would see
+    int z_min = -1, z_max = -1;
+    for (int j = 0; j < NUM_LIVE_KEYS; j++) {
+        if (LIVE_KEYS[j].f == &cfg_min_zoom) z_min = j;
+        if (LIVE_KEYS[j].f == &cfg_max_zoom) z_max = j;
+    }
+    float new_min = changed[z_min] ? staged[z_min] : cfg_min_zoom;
+    float new_max = changed[z_max] ? staged[z_max] : cfg_max_zoom;
+    if ((changed[z_min] || changed[z_max]) && new_min > new_max) {
+        fprintf(stderr, "\nConfig: rejected min_zoom=%g max_zoom=%g (min above max)\n", new_min, new_max);
+        changed[z_min] = changed[z_max] = 0;
+        num_rejected++;
+    }
+
+    for (int j = 0; j < NUM_LIVE_KEYS; j++) {
+        if (!changed[j]) continue;
+        const LiveKey *lk = &LIVE_KEYS[j];
+        if (lk->i) {
+            fprintf(stderr, "\nConfig: %s %d -> %d\n", lk->key, *lk->i, (int)staged[j]);
+            *lk->i = (int)staged[j];
+        } else {
+            fprintf(stderr, "\nConfig: %s %g -> %g\n", lk->key, *lk->f, staged[j]);
+            *lk->f = staged[j];
+        }
+        num_changed++;
+    }
+    remember_config_lines(lines, count);
+
+    // Settings the context keeps its own copy of
+    if (cfg_render_mode == RENDER_POINTS) ctx->hyper_spin = cfg_hyper_spin;
+    ctx->color_density_mix = cfg_color_density_mix;
+    if (ctx->scene) ctx->scene_multiplier = scene_multiplier(ctx);
+    if (num_changed || num_rejected) {
+        fprintf(stderr, "Config: reloaded '%s' at frame %d (%d changed, %d rejected)\n",
+                path, ctx->frame, num_changed, num_rejected);
+    }
+    return num_changed;
+}
+
+static char *copy_string(const char *s) {
+    if (!s) return NULL;
+    char *c = (char*)malloc(strlen(s) + 1);
+    if (c) strcpy(c, s);
+    return c;
+}
+
+// A new parameter set for the context's mode, from its decision stream
+static Params draw_params(ac_context *ctx, int type) {
+    return (ctx->mode == MODE_MAP) ? get_map_params(type, &ctx->decisions) : get_target_params(type, &ctx->decisions);
+}
+
+ac_context *ac_create(const ac_options *opt) {
+    int run_mode = opt->mode;
+    if (run_mode < 0 || run_mode > MODE_BIFURCATION) {
+        fprintf(stderr, "Error: mode %d has no context; use ac_run_lyapunov/ac_run_calibration\n", run_mode);
+        return NULL;
+    }
+    if (opt->width < 16 || opt->height < 16 || opt->num_particles < 1 || opt->frames_per_fragment < 1) {
+        fprintf(stderr, "Error: invalid context options\n");
+        return NULL;
+    }
+    if (run_mode == MODE_BIFURCATION && opt->num_particles / opt->width < 1) {
+        fprintf(stderr, "Error: bifurcation mode needs at least one particle per column (-p >= %d)\n", opt->width);
+        return NULL;
+    }
+    if (opt->proxy && run_mode != MODE_FLOW) {
+        fprintf(stderr, "Error: proxy mode supports flow mode only\n");
+        return NULL;
+    }
+
+    // Proxy: one particle in PROXY_STRIDE, rendered at 1/PROXY_SCALE size.
+    // Splats are weighted up by the particles and pixels each one stands for.
+    int id_stride = opt->proxy ? PROXY_STRIDE : 1;
+    int full_particles = opt->num_particles;
+    int num_particles = (full_particles + id_stride - 1) / id_stride;
+    int width = opt->proxy ? opt->width / PROXY_SCALE : opt->width;    // Render size
+    int height = opt->proxy ? opt->height / PROXY_SCALE : opt->height;
+
+    ac_context *ctx = (ac_context*)calloc(1, sizeof(ac_context));
+    if (!ctx) {
+        fprintf(stderr, "Error: out of memory creating the context\n");
+        return NULL;
+    }
+    ctx->mode = run_mode;
+    ctx->width = opt->width;
+    ctx->height = opt->height;
+    ctx->num_particles = ctx->alloc_particles = num_particles;
+    ctx->id_stride = id_stride;
+    ctx->full_particles = full_particles;
+    ctx->render_width = width;
+    ctx->render_height = height;
+    ctx->render_scale = opt->proxy ? 1.0f / PROXY_SCALE : 1.0f;
+    ctx->density_comp = opt->proxy ? (float)PROXY_STRIDE / (PROXY_SCALE * PROXY_SCALE) : 1.0f;
+    ctx->frames_per_fragment = opt->frames_per_fragment;
+    ctx->volume_prefix = copy_string(opt->volume_prefix);
+    ctx->ply_prefix = copy_string(opt->ply_prefix);
+    if ((opt->volume_prefix && !ctx->volume_prefix) || (opt->ply_prefix && !ctx->ply_prefix)) goto fail;
+    int num_types = (run_mode == MODE_MAP) ? NUM_MAP_TYPES : (run_mode == MODE_IFS) ? 1 :
+                    (run_mode == MODE_FLOW) ? NUM_TYPES : NUM_TYPES_3D;
+    int start_type = ((opt->start_type % num_types) + num_types) % num_types;
+    ctx->num_types = num_types;
+
+    // Open chapter log file
+    if (opt->chapter_log) {
+        ctx->log_file = fopen(opt->chapter_log, "w");
+        if (!ctx->log_file) {
+            fprintf(stderr, "Warning: Could not open %s for writing\n", opt->chapter_log);
+        }
+    }
+
+    float *h_x = ctx->h_x = (float*)malloc(num_particles * sizeof(float));
+    float *h_y = ctx->h_y = (float*)malloc(num_particles * sizeof(float));
+    float *h_z = ctx->h_z = (float*)malloc(num_particles * sizeof(float));
+    float *h_vx = ctx->h_vx = (float*)malloc(num_particles * sizeof(float));
+    float *h_vy = ctx->h_vy = (float*)malloc(num_particles * sizeof(float));
+    float *h_vz = ctx->h_vz = (float*)malloc(num_particles * sizeof(float));
+    float *accum_buffer = ctx->accum_buffer = (float*)malloc((size_t)width * height * 3 * sizeof(float));
+    size_t out_bytes = (size_t)ctx->width * ctx->height * 3;
+    unsigned char *out_buffer = ctx->out_buffer = (unsigned char*)malloc(out_bytes * sizeof(unsigned char));
+    if (!h_x || !h_y || !h_z || !h_vx || !h_vy || !h_vz || !accum_buffer || !out_buffer) goto fail;
+
+    // Placement and scene decisions draw from separate streams, so a proxy
+    // and a full render of the same seed switch to the same parameter sets
+    uint64_t seed = opt->seed ? opt->seed : (uint64_t)time(NULL) ^ (uint64_t)(uintptr_t)ctx;
+    ctx->placement = seed;
+    ctx->decisions = seed * 0xD1B54A32D192ED03ULL;
+
+    if (cfg_auto_calibrate && run_mode == MODE_FLOW) calibrate_framing(ATTRACTOR_BASE_MULTIPLIERS, &ctx->placement);
+
+    // Particle groups: a configured scene (flow mode), or one group covering
+    // every particle that follows the cycling attractor
+    int scene = ctx->scene = (run_mode == MODE_FLOW && cfg_group_count > 0);
+    int num_groups = ctx->num_groups = scene ? cfg_group_count : 1;
+    Group *groups = ctx->groups;
+    {
+        float share_total = 0.0f, share_acc = 0.0f;
+        for (int g = 0; g < cfg_group_count; g++) share_total += cfg_groups[g].share;
+        int begin = 0;
+        for (int g = 0; g < num_groups; g++) {
+            Group *gr = &groups[g];
+            memset(gr, 0, sizeof(*gr));
+            gr->scale = 1.0f;
+            gr->palette = PALETTE_HEAT;
+            gr->smooth_max_spd = 1.0f;
+            gr->begin = begin;
+            gr->end = full_particles;
+            int ens_param = cfg_ensemble_param;
+            float ens_spread = cfg_ensemble_spread;
+            if (scene) {
+                const GroupSpec *spec = &cfg_groups[g];
+                share_acc += spec->share;
+                if (g < num_groups - 1) gr->end = (int)(full_particles * (share_acc / share_total));
+                gr->type = gr->prev_type = spec->type;
+                gr->p = draw_params(ctx, spec->type);
+                gr->scale = spec->scale;
+                gr->ox = spec->ox; gr->oy = spec->oy; gr->oz = spec->oz;
+                gr->palette = spec->palette;
+                gr->share = spec->share / share_total;
+                ens_param = spec->ens_param;
+                ens_spread = spec->ens_spread;
+            }
+            if (run_mode == MODE_FLOW && ens_param >= 0 && ens_spread != 0.0f) {
+                gr->ensemble = 1;
+                if (scene) {
+                    // A scene group's params are fixed, so its width is set once
+                    ((float*)&gr->dp)[ens_param] = ens_spread * fabsf(((const float*)&gr->p)[ens_param]);
+                    fprintf(stderr, "Group %d: ensemble over %c, spread %.0f%% of its value\n", g, 'a' + ens_param, ens_spread * 100.0f);
+                } else {
+                    // dp is set per frame in ac_step, relative to the cycling type's value
+                    fprintf(stderr, "Ensemble over %c, spread %.0f%% of its value\n", 'a' + ens_param, ens_spread * 100.0f);
+                }
+            }
+            begin = gr->end;
+        }
+        // Ranges so far are in the full population; map them to the kept particles
+        for (int g = 0; g < num_groups; g++) {
+            Group *gr = &groups[g];
+            gr->id_stride = id_stride;
+            gr->id_begin = gr->begin;
+            gr->id_count = gr->end - gr->begin;
+            gr->id_total = full_particles;
+            gr->begin = (gr->begin + id_stride - 1) / id_stride;
+            gr->end = (gr->end + id_stride - 1) / id_stride;
+        }
+    }
+    if (scene) ctx->scene_multiplier = scene_multiplier(ctx);
+
+    // Low-discrepancy placement, randomized per run
+    Sampler sampler = {cfg_init_sampler, {0, 0, 0}};
+    if (sampler.kind != SAMPLER_RAND) {
+        for (int k = 0; k < 3; k++) sampler.shift[k] = stream_u32(&ctx->placement);
+    }
+    ctx->sampler = sampler;
+
+    // Initial Box (in each group's scene space)
+    for (int g = 0; g < num_groups; g++) {
+        float ox = groups[g].ox, oy = groups[g].oy, oz = groups[g].oz, scale = groups[g].scale;
+        int begin = groups[g].begin, count = groups[g].end - groups[g].begin;
+        int id_begin = groups[g].id_begin, id_end = id_begin + groups[g].id_count;
+        if (sampler.kind == SAMPLER_RAND) {
+            // Draws run over the full population, so kept particles start where they would in full
+            for (int id = id_begin; id < id_end; id++) {
+                float x = ox + scale * rand_range_cpu(&ctx->placement, -5.0f, 5.0f);
+                float y = oy + scale * rand_range_cpu(&ctx->placement, -5.0f, 5.0f);
+                float z = oz + scale * rand_range_cpu(&ctx->placement, -5.0f, 5.0f);
+                int i = id / id_stride;
+                if (i >= begin && i < begin + count && particle_id(i, id_stride, id_end) == id) {
+                    h_x[i] = x; h_y[i] = y; h_z[i] = z;
+                }
+            }
+        } else {
+            // Each group restarts the sequence so it covers its own box evenly
+            #pragma acc parallel loop copyout(h_x[begin:count], h_y[begin:count], h_z[begin:count])
+            for (int i = begin; i < begin + count; i++) {
+                float u0, u1, u2;
+                sample_point(sampler, (uint32_t)(particle_id(i, id_stride, id_end) - id_begin), &u0, &u1, &u2);
+                h_x[i] = ox + scale * (u0 * 10.0f - 5.0f);
+                h_y[i] = oy + scale * (u1 * 10.0f - 5.0f);
+                h_z[i] = oz + scale * (u2 * 10.0f - 5.0f);
+            }
+        }
+        for (int i = begin; i < begin + count; i++) {
+            h_vx[i] = h_vy[i] = h_vz[i] = 0.0f;
+            if (run_mode == MODE_MAP) h_z[i] = 0.0f;  // Maps live in the z=0 plane
+            if (run_mode == MODE_IFS) h_z[i] = 0.5f;  // IFS color coordinate
+        }
+    }
+
+    if (cfg_denoise) {
+        float *denoise_guide = ctx->denoise_guide = (float*)malloc((size_t)width * height * sizeof(float));
+        float *denoise_buffer = ctx->denoise_buffer = (float*)malloc((size_t)width * height * 3 * sizeof(float));
+        if (!denoise_guide || !denoise_buffer) goto fail;
+        #pragma acc enter data create(denoise_guide[0:width*height], denoise_buffer[0:width*height*3])
+    }
+
+    int temporal_frames = (opt->temporal_frames >= 0) ? opt->temporal_frames : cfg_temporal_frames;
+    ctx->temporal_frames = temporal_frames < 64 ? temporal_frames : 64;
+    int temporal = ctx->temporal = (run_mode == MODE_FLOW && cfg_render_mode == RENDER_POINTS && ctx->temporal_frames > 1);
+    size_t history_cells = ctx->history_cells = temporal ? (size_t)width * height : 1;
+    float *frame_depth = ctx->frame_depth = (float*)calloc(history_cells, sizeof(float));
+    if (!frame_depth) goto fail;
+    #pragma acc enter data copyin(frame_depth[0:history_cells])
+    if (temporal) {
+        for (int h = 0; h < 2; h++) {
+            float *history_rgb = ctx->history_rgb[h] = (float*)calloc(history_cells * 3, sizeof(float));
+            float *history_n = ctx->history_n[h] = (float*)calloc(history_cells, sizeof(float));
+            float *history_depth = ctx->history_depth[h] = (float*)calloc(history_cells, sizeof(float));
+            if (!history_rgb || !history_n || !history_depth) goto fail;
+            #pragma acc enter data copyin(history_rgb[0:history_cells*3], history_n[0:history_cells], \
+                                          history_depth[0:history_cells])
+        }
+    }
+    ctx->prev_view = (ViewState){0.0f, 0.0f, 0.0f, 1.0f};
+
+    #pragma acc enter data copyin(h_x[0:num_particles], h_y[0:num_particles], h_z[0:num_particles], \
+                                  h_vx[0:num_particles], h_vy[0:num_particles], h_vz[0:num_particles]) \
+                         create(accum_buffer[0:width*height*3], out_buffer[0:out_bytes])
+    if (opt->proxy) {
+        float *proxy_accum = ctx->proxy_accum = (float*)malloc((size_t)width * height * 3 * sizeof(float));
+        unsigned char *proxy_rgb = ctx->proxy_rgb = (unsigned char*)malloc((size_t)width * height * 3);
+        if (!proxy_accum || !proxy_rgb) goto fail;
+        #pragma acc enter data create(proxy_accum[0:width*height*3], proxy_rgb[0:width*height*3])
+    }
+
+    // Fourth SoA component, zeroed so 3D starts are unchanged; other modes get a stub
+    size_t w_cells = ctx->w_cells = (run_mode == MODE_FLOW) ? (size_t)num_particles : 1;
+    float *h_w = ctx->h_w = (float*)calloc(w_cells, sizeof(float));
+    float *h_vw = ctx->h_vw = (float*)calloc(w_cells, sizeof(float));
+    if (!h_w || !h_vw) goto fail;
+    #pragma acc enter data copyin(h_w[0:w_cells], h_vw[0:w_cells])
+
+    // Reduced-rate physics: key1 holds the integrated positions (velocities
+    // stay in h_v*), key0 the state one interval earlier, and the h_ positions
+    // the interpolated particles that are drawn
+    int physics_interval = (opt->physics_interval > 0) ? opt->physics_interval : cfg_physics_interval;
+    ctx->physics_k = (run_mode != MODE_FLOW) ? 1 : physics_interval < 4 ? physics_interval : 4;
+    ctx->interp = ctx->physics_k > 1;
+    float *display[KEY_COMPONENTS] = {h_x, h_y, h_z, h_w, h_vx, h_vy, h_vz, h_vw};
+    memcpy(ctx->display, display, sizeof(display));
+    if (ctx->interp) {
+        for (int c = 0; c < KEY_COMPONENTS; c++) {
+            float *key0 = ctx->key0[c] = (float*)malloc(num_particles * sizeof(float));
+            if (!key0) goto fail;
+            #pragma acc enter data create(key0[0:num_particles])
+            if (c >= 4) { ctx->key1[c] = display[c]; continue; }
+            float *key1 = ctx->key1[c] = (float*)malloc(num_particles * sizeof(float));
+            if (!key1) goto fail;
+            memcpy(key1, display[c], num_particles * sizeof(float));
+            #pragma acc enter data copyin(key1[0:num_particles])
+        }
+    }
+
+    // Trail ring buffer: trail_len quantized slots per particle, slot-major so
+    // the physics kernel's writes stay coalesced. Seeded with the start positions.
+    int trail_len = ctx->trail_len = (cfg_render_mode == RENDER_TRAILS) ? cfg_trail_length : 0;
+    size_t trail_cells = ctx->trail_cells = trail_len > 0 ? (size_t)trail_len * num_particles : 1;
+    int16_t *trail_x = ctx->trail_x = (int16_t*)malloc(trail_cells * sizeof(int16_t));
+    int16_t *trail_y = ctx->trail_y = (int16_t*)malloc(trail_cells * sizeof(int16_t));
+    int16_t *trail_z = ctx->trail_z = (int16_t*)malloc(trail_cells * sizeof(int16_t));
+    if (!trail_x || !trail_y || !trail_z) goto fail;
+    #pragma acc enter data create(trail_x[0:trail_cells], trail_y[0:trail_cells], trail_z[0:trail_cells])
+    if (trail_len > 0) {
+        #pragma acc parallel loop present(h_x, h_y, h_z, trail_x, trail_y, trail_z)
+        for (size_t c = 0; c < trail_cells; c++) {
+            int i = (int)(c % num_particles);
+            trail_x[c] = quantize_trail(h_x[i]);
+            trail_y[c] = quantize_trail(h_y[i]);
+            trail_z[c] = quantize_trail(h_z[i]);
+        }
+    }
+
+    // Occupancy grid for density coloring; small enough to stay cache/L2 resident
+    int occ_res = ctx->occ_res = cfg_occupancy_res;
+    size_t occ_cells = ctx->occ_cells = (size_t)occ_res * occ_res * occ_res;
+    float *occupancy = ctx->occupancy = (float*)calloc(occ_cells, sizeof(float));
+    if (!occupancy) goto fail;
+    #pragma acc enter data copyin(occupancy[0:occ_cells])
+    ctx->occ_bounds = compute_particle_bounds(h_x, h_y, h_z, num_particles, STATS_STRIDE / id_stride);
+    ctx->color_mode = cfg_color_mode;
+    ctx->color_density_mix = cfg_color_density_mix;
+
+    // Ray-march grids (RENDER_VOLUME only)
+    if (cfg_render_mode == RENDER_VOLUME) {
+        size_t march_cells = ctx->march_cells = (size_t)cfg_march_res * cfg_march_res * cfg_march_res;
+        float *march_density = ctx->march_density = (float*)malloc(march_cells * sizeof(float));
+        float *march_speed = ctx->march_speed = (float*)malloc(march_cells * sizeof(float));
+        if (!march_density || !march_speed) goto fail;
+        #pragma acc enter data create(march_density[0:march_cells], march_speed[0:march_cells])
+        ctx->march_bounds = compute_particle_bounds(h_x, h_y, h_z, num_particles, STATS_STRIDE / id_stride);
+    }
+
+    // Bifurcation columns: one per output pixel column, laid out contiguously
+    ctx->bif_v_scale = ctx->bif_inv_max_spd = 1.0f;
+    if (run_mode == MODE_BIFURCATION) {
+        ctx->bif_per_col = num_particles / width;
+        ctx->num_particles = ctx->full_particles = ctx->bif_per_col * width;
+        groups[0].end = groups[0].id_count = ctx->num_particles;
+    }
+
+    // Map/IFS/bifurcation hit buffers
+    if (run_mode == MODE_MAP || run_mode == MODE_IFS || run_mode == MODE_BIFURCATION) {
+        uint32_t *map_hits = ctx->map_hits = (uint32_t*)calloc(width * height, sizeof(uint32_t));
+        float *map_color = ctx->map_color = (float*)calloc(width * height, sizeof(float));
+        if (!map_hits || !map_color) goto fail;
+        #pragma acc enter data copyin(map_hits[0:width*height], map_color[0:width*height])
+    }
+
+    // Density grid export state (one volume per cfg_volume_frames frames)
+    if (ctx->volume_prefix) {
+        size_t volume_cells = ctx->volume_cells = (size_t)cfg_volume_res * cfg_volume_res * cfg_volume_res;
+        float *volume_grid = ctx->volume_grid = (float*)calloc(volume_cells, sizeof(float));
+        if (!volume_grid) goto fail;
+        #pragma acc enter data copyin(volume_grid[0:volume_cells])
+    }
+
+    ctx->current_type = ctx->previous_type = start_type;
+    ctx->cur_p = draw_params(ctx, start_type);
+    ctx->target_p = ctx->prev_p = ctx->cur_p;
+    ctx->base_multipliers = (run_mode == MODE_MAP) ? MAP_BASE_MULTIPLIERS :
+                            (run_mode == MODE_IFS) ? &cfg_ifs_multiplier : ATTRACTOR_BASE_MULTIPLIERS;
+
+    // IFS transforms from config, or the built-in default
+    ctx->ifs_count = cfg_ifs_count;
+    if (ctx->ifs_count > 0) memcpy(ctx->ifs_xf, cfg_ifs, ctx->ifs_count * sizeof(IfsTransform));
+    else ctx->ifs_count = default_ifs(ctx->ifs_xf);
+    if (run_mode == MODE_IFS) {
+        float weight_total = 0.0f;
+        for (int t = 0; t < ctx->ifs_count; t++) weight_total += fmaxf(ctx->ifs_xf[t].weight, 0.0f);
+        if (!(weight_total > 0.0f)) fprintf(stderr, "Warning: no IFS transform has a positive weight, using equal weights\n");
+    }
+
+    // Log initial attractor
+    FILE *log_file = ctx->log_file;
+    if (run_mode == MODE_MAP) log_map(log_file, 0, 0, start_type, ctx->cur_p);
+    else if (run_mode == MODE_IFS) log_ifs(log_file, ctx->ifs_xf, ctx->ifs_count);
+    else if (scene) for (int g = 0; g < num_groups; g++) log_attractor(log_file, 0, 0, groups[g].type, groups[g].p);
+    else log_attractor(log_file, 0, 0, start_type, ctx->cur_p);
+
+    ctx->cam_scale = (cfg_initial_cam_scale > 0) ? cfg_initial_cam_scale : 100.0f;
+    ctx->cam_follow = 0.005f;
+    ctx->smooth_max_spd = 1.0f;
+    ctx->smooth_base_multiplier = scene ? ctx->scene_multiplier : ctx->base_multipliers[start_type];
+    ctx->transition_blend = ctx->prev_blend = 1.0f;
+    ctx->start_type = start_type;
+    ctx->zoom = ctx->exposure = 1.0f;
+
+    // x-w view rotation for 4D types (point render only). It turns while a 4D
+    // type is on screen, then finishes its revolution and parks at zero.
+    ctx->hyper_spin = (cfg_render_mode == RENDER_POINTS) ? cfg_hyper_spin : 0.0f;
+    ctx->cos_h = 1.0f;
+    return ctx;
+
+fail:
+    fprintf(stderr, "Error: out of memory creating the context\n");
+    ac_destroy(ctx);
+    return NULL;
+}
+
+// Start a transition to another type (single-group flow and map modes)
+static void switch_type(ac_context *ctx, int type) {
+    ctx->previous_type = ctx->current_type;  // Save old type for blending
+    ctx->current_type = type;
+    ctx->algo_timer = 0;
+    ctx->transition_blend = 0.0f;            // Start blending from previous
+    // Only get new random params when attractor TYPE changes
+    if (ctx->mode == MODE_MAP) {
+        // Maps diverge on foreign params, so switch outright and cross-fade particles
+        ctx->prev_p = ctx->cur_p;
+        ctx->target_p = ctx->cur_p = draw_params(ctx, ctx->current_type);
+    } else {
+        ctx->target_p = draw_params(ctx, ctx->current_type);
+    }
+
+    // Log attractor type change with timestamp
+    int total_seconds = ctx->frame / LOG_FRAMERATE;
+    int mins = total_seconds / 60;
+    int secs = total_seconds % 60;
+    if (ctx->mode == MODE_MAP) log_map(ctx->log_file, mins, secs, ctx->current_type, ctx->target_p);
+    else log_attractor(ctx->log_file, mins, secs, ctx->current_type, ctx->target_p);
+}
+
+// --- Live Control ---
+int ac_post_command(ac_context *ctx, const char *line) {
+    CommandQueue *q = &ctx->commands;
+    unsigned int tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    if (tail - atomic_load_explicit(&q->head, memory_order_acquire) == COMMAND_QUEUE_SIZE) return -1;
+    char *slot = q->lines[tail % COMMAND_QUEUE_SIZE];
+    snprintf(slot, COMMAND_LENGTH, "%s", line);
+    slot[strcspn(slot, "\r\n")] = '\0';
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+    return 0;
+}
+
+static int type_from_name(const ac_context *ctx, const char *name) {
+    char *end;
+    long type = strtol(name, &end, 10);
+    if (*end == '\0' && end != name) return (type >= 0 && type < ctx->num_types) ? (int)type : -1;
+    for (int t = 0; t < ctx->num_types; t++) {
+        const char *known = (ctx->mode == MODE_MAP) ? MAP_NAMES[t] : ATTRACTOR_NAMES[t];
+        if (strcasecmp(name, known) == 0) return t;
+    }
+    return -1;
+}
+
+// Apply one command line; anything malformed is reported and ignored
+static void apply_command(ac_context *ctx, const char *line) {
+    char cmd[32] = "", arg[32] = "";
+    float a = 0.0f, b = 0.0f;
+    int words = sscanf(line, "%31s %31s", cmd, arg);
+    if (words < 1) return;
+    int schedule = (ctx->mode == MODE_FLOW && !ctx->scene) || ctx->mode == MODE_MAP;
+
+    if (strcmp(cmd, "type") == 0 && words == 2) {
+        int type = type_from_name(ctx, arg);
+        if (!schedule || type < 0) {
+            fprintf(stderr, schedule ? "\nControl: unknown type '%s'\n" :
+                    "\nControl: ignored 'type %s' (single-scene flow and map modes only)\n", arg);
+            return;
+        }
+        if (type != ctx->current_type) switch_type(ctx, type);
+    } else if (strcmp(cmd, "param") == 0 && sscanf(line, "%*s %31s %f", arg, &a) == 2 &&
+               strlen(arg) == 1 && arg[0] >= 'a' && arg[0] <= 'f' && isfinite(a)) {
+        // Groups keep their own params and IFS has none, so nothing would read the target
+        if (ctx->scene || ctx->mode == MODE_IFS) {
+            fprintf(stderr, "\nControl: ignored '%s' (not in layered scenes or IFS mode)\n", line);
+            return;
+        }
+        // Set the target; the current params ease towards it as on a type switch
+        float *target = &ctx->target_p.a + (arg[0] - 'a');
+        *target = a;
+    } else if (strcmp(cmd, "pan") == 0 && sscanf(line, "%*s %f %f", &a, &b) == 2 && isfinite(a) && isfinite(b)) {
+        ctx->pan_x += a;
+        ctx->pan_y += b;
+    } else if (strcmp(cmd, "zoom") == 0 && sscanf(line, "%*s %f", &a) == 1 && a > 0.0f && isfinite(a)) {
+        ctx->zoom *= a;
+    } else if (strcmp(cmd, "exposure") == 0 && sscanf(line, "%*s %f", &a) == 1 && a > 0.0f && isfinite(a)) {
+        ctx->exposure = a;
+    } else if (strcmp(cmd, "reset") == 0 && words == 1) {
+        ctx->pan_x = ctx->pan_y = 0.0f;
+        ctx->zoom = ctx->exposure = 1.0f;
+    } else if (strcmp(cmd, "pause") == 0 && words == 1) {
+        ctx->paused = 1;
+    } else if (strcmp(cmd, "resume") == 0 && words == 1) {
+        ctx->paused = 0;
+    } else if (strcmp(cmd, "seek") == 0 && sscanf(line, "%*s %f", &a) == 1 && a >= 0.0f && a < 1e9f) {
+        // Move the schedule clock as if it had run to that frame: the orbit,
+        // zoom breathing and next switch follow it, and the type it would
+        // show is blended in (with fresh params; particles are kept)
+        int frame = ctx->frame = (int)a;
+        int fragments = (frame + ctx->frames_per_fragment - 1) / ctx->frames_per_fragment;
+        if (schedule) {
+            int type = (ctx->start_type + fragments / 6) % ctx->num_types;
+            if (type != ctx->current_type) switch_type(ctx, type);
+            ctx->algo_timer = fragments % 6;
+        }
+    } else {
+        fprintf(stderr, "\nControl: ignored '%s'\n", line);
+        return;
+    }
+    fprintf(stderr, "\nControl: %s\n", line);
+}
+
+void ac_step(ac_context *ctx) {
+    // Commands queued since the last frame take effect before it
+    CommandQueue *q = &ctx->commands;
+    unsigned int head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    for (; head != tail; head++) {
+        apply_command(ctx, q->lines[head % COMMAND_QUEUE_SIZE]);
+        atomic_store_explicit(&q->head, head + 1, memory_order_release);
+    }
+    if (ctx->paused) return;
+
+    int run_mode = ctx->mode, width = ctx->width, height = ctx->height;
+    int num_particles = ctx->num_particles, num_groups = ctx->num_groups, scene = ctx->scene;
+    int frame = ctx->frame, render_width = ctx->render_width, render_height = ctx->render_height;
+    float *h_x = ctx->h_x, *h_y = ctx->h_y, *h_z = ctx->h_z, *h_w = ctx->h_w;
+    float *h_vx = ctx->h_vx, *h_vy = ctx->h_vy, *h_vz = ctx->h_vz;
+    uint32_t *map_hits = ctx->map_hits;
+    float *map_color = ctx->map_color;
+    Group *groups = ctx->groups;
+
+    if ((ctx->volume_prefix || ctx->ply_prefix) && !ctx->writing) {
+        writer_start();
+        ctx->writing = 1;
+    }
+
+    if (frame % ctx->frames_per_fragment == 0 && ((run_mode == MODE_FLOW && !scene) || run_mode == MODE_MAP)) {
+        ctx->algo_timer++;
+        if (ctx->algo_timer >= 6) switch_type(ctx, (ctx->current_type + 1) % ctx->num_types);
+    }
+    int current_type = ctx->current_type, previous_type = ctx->previous_type;
+
+    // Smoothly transition base multiplier when attractor changes
+    float target_base_multiplier = scene ? ctx->scene_multiplier : ctx->base_multipliers[current_type];
+    ctx->smooth_base_multiplier += (target_base_multiplier - ctx->smooth_base_multiplier) * 0.02f;
+
+    Params *cur_p = &ctx->cur_p, target_p = ctx->target_p;
+    float lerp = 0.02f;
+    cur_p->a += (target_p.a - cur_p->a)*lerp; cur_p->b += (target_p.b - cur_p->b)*lerp;
+    cur_p->c += (target_p.c - cur_p->c)*lerp; cur_p->d += (target_p.d - cur_p->d)*lerp;
+    cur_p->e += (target_p.e - cur_p->e)*lerp; cur_p->f += (target_p.f - cur_p->f)*lerp;
+
+    // Progress attractor transition blend
+    float prev_blend = ctx->prev_blend = ctx->transition_blend;
+    if (ctx->transition_blend < 1.0f) {
+        ctx->transition_blend += 1.0f / TRANSITION_FRAMES;
+        if (ctx->transition_blend > 1.0f) ctx->transition_blend = 1.0f;
+    }
+    float transition_blend = ctx->transition_blend;
+
+    // Maps and IFS are planar, so they are shown face-on without the orbit
+    float theta = ctx->theta = (run_mode == MODE_MAP || run_mode == MODE_IFS) ? 0.0f : frame * 0.005f;
+    float cos_t = cosf(theta);
+    float sin_t = sinf(theta);
+
+    // The single cycling group follows the global attractor state
+    if (!scene) {
+        groups[0].type = current_type;
+        groups[0].prev_type = previous_type;
+        groups[0].p = *cur_p;
+        // The same absolute width would be tiny for one type and push another
+        // past its escape bound, so the sweep scales with the swept value
+        if (groups[0].ensemble) {
+            int k = cfg_ensemble_param;
+            ((float*)&groups[0].dp)[k] = cfg_ensemble_spread * fabsf(((const float*)cur_p)[k]);
+        }
+    }
+
+    int hyper_active = 0;
+    for (int g = 0; g < num_groups; g++) {
+        groups[g].dims = (ATTRACTOR_DIMS[groups[g].type] == 4 ||
+                          (transition_blend < 1.0f && ATTRACTOR_DIMS[groups[g].prev_type] == 4)) ? 4 : 3;
+        if (run_mode == MODE_FLOW && groups[g].dims == 4) hyper_active = 1;
+    }
+    if (hyper_active || ctx->hyper_phase > 0.0f) {
+        ctx->hyper_phase += ctx->hyper_spin;
+        if (ctx->hyper_phase >= 2.0f * M_PI) ctx->hyper_phase = hyper_active ? ctx->hyper_phase - 2.0f * M_PI : 0.0f;
+    }
+    int hyper_view = ctx->hyper_view = ctx->hyper_phase > 0.0f;
+    float cos_h = ctx->cos_h = cosf(ctx->hyper_phase);
+    float sin_h = ctx->sin_h = sinf(ctx->hyper_phase);
+    // Keep w evolving (and relaxing) for as long as the view still mixes it in
+    if (!scene && hyper_view) groups[0].dims = 4;
+    if (cfg_symmetry && run_mode == MODE_FLOW) {
+        for (int g = 0; g < num_groups; g++) resolve_symmetry_images(&groups[g], transition_blend);
+    }
+
+    // --- PHYSICS UPDATE ---
+    int physics_k = ctx->physics_k, trail_len = ctx->trail_len;
+    int trail_head = ctx->trail_head = (trail_len > 0) ? (frame / physics_k) % trail_len : 0;
+    if (run_mode == MODE_MAP) {
+        // Iteration and splatting are fused; splats use last frame's (smoothed) camera
+        iterate_maps(h_x, h_y, h_vx, h_vy, num_particles, current_type, *cur_p, previous_type, ctx->prev_p,
+                     transition_blend, prev_blend, frame == 0, cfg_map_iterations, map_hits, map_color,
+                     render_width, render_height, ctx->cam_cx, ctx->cam_cy, ctx->cam_scale, ctx->smooth_max_spd, frame);
+    } else if (run_mode == MODE_IFS) {
+        // Animate by spinning transform 0's linear part
+        const IfsTransform *ifs_xf = ctx->ifs_xf;
+        IfsTransform spun[MAX_IFS_TRANSFORMS];
+        memcpy(spun, ifs_xf, ctx->ifs_count * sizeof(IfsTransform));
+        float ca = cosf(frame * cfg_ifs_spin), sa = sinf(frame * cfg_ifs_spin);
+        spun[0].a = ca * ifs_xf[0].a - sa * ifs_xf[0].d; spun[0].d = sa * ifs_xf[0].a + ca * ifs_xf[0].d;
+        spun[0].b = ca * ifs_xf[0].b - sa * ifs_xf[0].e; spun[0].e = sa * ifs_xf[0].b + ca * ifs_xf[0].e;
+        iterate_ifs(h_x, h_y, h_z, h_vx, h_vy, num_particles, build_ifs_system(spun, ctx->ifs_count),
+                    frame == 0, cfg_map_iterations, map_hits, map_color, render_width, render_height,
+                    ctx->cam_cx, ctx->cam_cy, ctx->cam_scale, frame);
+    } else if (run_mode == MODE_BIFURCATION) {
+        int bif_per_col = ctx->bif_per_col;
+        float p_step = (cfg_bif_max - cfg_bif_min) / (width > 1 ? width - 1 : 1);
+        if (frame == 0) {
+            // Skip the transient, then fix the vertical range and speed scale
+            integrate_bifurcation(h_x, h_y, h_z, h_vx, h_vy, h_vz, num_particles, bif_per_col,
+                                  current_type, *cur_p, cfg_bif_param, cfg_bif_min, p_step,
+                                  cfg_bif_transient, cfg_bif_substeps, 0, cfg_bif_axis, cfg_bif_maxima,
+                                  0.0f, 0.0f, 0.0f, map_hits, map_color, render_width, render_height);
+            Bounds b = compute_particle_bounds(h_x, h_y, h_z, num_particles, 1);
+            float lo = (cfg_bif_axis == 0) ? b.min_x : (cfg_bif_axis == 1) ? b.min_y : b.min_z;
+            float hi = (cfg_bif_axis == 0) ? b.max_x : (cfg_bif_axis == 1) ? b.max_y : b.max_z;
+            // The maximum maps to the top row; a column set that has all
+            // converged to one value gets a unit range around it
+            if (!(hi - lo > 1e-6f * fmaxf(1.0f, fabsf(hi)))) {
+                lo -= 0.5f;
+                hi += 0.5f;
+            }
+            ctx->bif_v_min = lo;
+            ctx->bif_v_scale = (height - 1) / (hi - lo);
+
+            float bif_max_spd = 1e-3f;
+            #pragma acc parallel loop present(h_vx, h_vy, h_vz) reduction(max:bif_max_spd)
+            for (int i = 0; i < num_particles; i++) {
+                float spd = sqrtf(h_vx[i]*h_vx[i] + h_vy[i]*h_vy[i] + h_vz[i]*h_vz[i]);
+                if (spd > bif_max_spd) bif_max_spd = spd;
+            }
+            ctx->bif_inv_max_spd = 1.0f / bif_max_spd;
+        }
+        integrate_bifurcation(h_x, h_y, h_z, h_vx, h_vy, h_vz, num_particles, bif_per_col,
+                              current_type, *cur_p, cfg_bif_param, cfg_bif_min, p_step,
+                              cfg_bif_steps, cfg_bif_substeps, 1, cfg_bif_axis, cfg_bif_maxima,
+                              ctx->bif_v_min, ctx->bif_v_scale, ctx->bif_inv_max_spd, map_hits, map_color,
+                              render_width, render_height);
+        ctx->bif_plotted_steps += cfg_bif_steps;
+    } else {
+        // With physics_interval k the keys advance by k*DT every k-th frame
+        // and the particles drawn in between are interpolated
+        float **key0 = ctx->key0, **key1 = ctx->key1;
+        float *const *state = ctx->interp ? key1 : ctx->display;
+        if (frame % physics_k == 0) {
+            for (int c = 0; c < KEY_COMPONENTS && ctx->interp; c++) {
+                float *src = key1[c], *dst = key0[c];
+                #pragma acc parallel loop present(src, dst)
+                for (int i = 0; i < num_particles; i++) dst[i] = src[i];
+            }
+            for (int g = 0; g < num_groups; g++) {
+                if (groups[g].dims == 4) {
+                    integrate_flow_4d(state[0], state[1], state[2], state[3], state[4], state[5], state[6], state[7],
+                                      num_particles, groups[g], transition_blend, physics_k * DT, ctx->sampler,
+                                      ctx->trail_x, ctx->trail_y, ctx->trail_z, trail_len, trail_head);
+                } else {
+                    integrate_flow_3d(state[0], state[1], state[2], state[4], state[5], state[6],
+                                      num_particles, groups[g], transition_blend, physics_k * DT, ctx->sampler,
+                                      ctx->trail_x, ctx->trail_y, ctx->trail_z, trail_len, trail_head);
+                }
+            }
+            ctx->sampler.round++;
+        }
+        if (ctx->interp) {
+            float s = (float)(frame % physics_k + 1) / physics_k;
+            for (int g = 0; g < num_groups; g++) {
+                interpolate_particles(key0, key1, h_x, h_y, h_z, h_w, groups[g], s);
+            }
+        }
+    }
+
+    // --- STATS (MEAN & MAD) ---
+    // The sample grid is on particle identities, so a proxy samples the same particles
+    int sample_stride = STATS_STRIDE / ctx->id_stride;
+    int num_samples = ctx->full_particles / STATS_STRIDE;
+    // Reduced per group range (on the global sample grid) so each group
+    // gets its own speed normalization and view rotation
+    float sum_x = 0, sum_y = 0, max_spd = 0.0f;
+    float group_max_spd[MAX_GROUPS];
+    for (int g = 0; g < num_groups; g++) {
+        int first = (groups[g].begin + sample_stride - 1) / sample_stride * sample_stride;
+        int rotate = hyper_view && groups[g].dims == 4;
+        float ox = groups[g].ox, w_sin = groups[g].scale * sin_h;
+        float g_sum_x = 0, g_sum_y = 0, g_max_spd = 0.0f;
+        #pragma acc parallel loop present(h_x, h_y, h_z, h_w, h_vx, h_vy, h_vz) reduction(+:g_sum_x, g_sum_y) reduction(max:g_max_spd)
+        for (int i = first; i < groups[g].end; i+=sample_stride) {
+            float x = h_x[i]; float z = h_z[i]; float y = h_y[i];
+            if (rotate) x = ox + (x - ox) * cos_h - h_w[i] * w_sin;
+            float rx = x * cos_t - z * sin_t;
+            float ry = y;
+            g_sum_x += rx; g_sum_y += ry;
+            float spd = sqrtf(h_vx[i]*h_vx[i] + h_vy[i]*h_vy[i] + h_vz[i]*h_vz[i]);
+            if (spd > g_max_spd) g_max_spd = spd;
+        }
+        sum_x += g_sum_x; sum_y += g_sum_y;
+        group_max_spd[g] = g_max_spd;
+        if (g_max_spd > max_spd) max_spd = g_max_spd;
+    }
+    float center_x = sum_x / num_samples;
+    float center_y = sum_y / num_samples;
+
+    float sum_dist_x = 0, sum_dist_y = 0;
+    for (int g = 0; g < num_groups; g++) {
+        int first = (groups[g].begin + sample_stride - 1) / sample_stride * sample_stride;
+        int rotate = hyper_view && groups[g].dims == 4;
+        float ox = groups[g].ox, w_sin = groups[g].scale * sin_h;
+        float g_dist_x = 0, g_dist_y = 0;
+        #pragma acc parallel loop present(h_x, h_y, h_z, h_w) reduction(+:g_dist_x, g_dist_y)
+        for (int i = first; i < groups[g].end; i+=sample_stride) {
+            float x = h_x[i]; float z = h_z[i]; float y = h_y[i];
+            if (rotate) x = ox + (x - ox) * cos_h - h_w[i] * w_sin;
+            float rx = x * cos_t - z * sin_t;
+            float ry = y;
+            g_dist_x += fabsf(rx - center_x);
+            g_dist_y += fabsf(ry - center_y);
+        }
+        sum_dist_x += g_dist_x; sum_dist_y += g_dist_y;
+    }
+    float mean_dist_x = sum_dist_x / num_samples;
+    float mean_dist_y = sum_dist_y / num_samples;
+
+    // --- SINUSOIDAL ZOOM ANIMATION ---
+    // Create breathing effect over each fragment duration
+    int fragment_frame = frame % ctx->frames_per_fragment;
+    float cycle_progress = (float)fragment_frame / (float)ctx->frames_per_fragment;
+    float zoom_wave = sinf(cycle_progress * 2.0f * M_PI);  // -1 to +1
+    float sinusoidal_factor = 1.0f + zoom_wave * cfg_zoom_oscillation;
+
+    // --- DYNAMIC ADJUSTMENT ---
+    // Adjust zoom based on particle velocity variance
+    float velocity_ratio = max_spd / (ctx->smooth_max_spd + 0.001f);  // Avoid division by zero
+    float dynamic_factor = 1.0f + (velocity_ratio - 1.0f) * cfg_dynamic_adjustment;
+    if (dynamic_factor < 0.85f) dynamic_factor = 0.85f;
+    if (dynamic_factor > 1.15f) dynamic_factor = 1.15f;
+
+    // --- CINEMATIC ZOOM CALCULATION ---
+    // Apply hybrid multiplier: base × dynamic × sinusoidal
+    float combined_multiplier = ctx->smooth_base_multiplier * dynamic_factor * sinusoidal_factor;
+    float target_w = mean_dist_x * combined_multiplier;
+    float target_h = mean_dist_y * combined_multiplier;
+
+    if (target_w < 1.0f) target_w = 1.0f;
+    if (target_h < 1.0f) target_h = 1.0f;
+
+    float scale_w = (width * cfg_screen_fill_factor) / target_w;
+    float scale_h = (height * cfg_screen_fill_factor) / target_h;
+    float target_scale = (scale_w < scale_h) ? scale_w : scale_h;
+
+    target_scale *= ctx->zoom;
+    if (target_scale < cfg_min_zoom) target_scale = cfg_min_zoom;
+    if (target_scale > cfg_max_zoom) target_scale = cfg_max_zoom;
+
+    float follow = ctx->cam_follow;
+    ctx->cam_scale += (target_scale - ctx->cam_scale) * follow;
+    ctx->cam_cx += (center_x + ctx->pan_x * height / ctx->cam_scale - ctx->cam_cx) * follow;
+    ctx->cam_cy += (center_y + ctx->pan_y * height / ctx->cam_scale - ctx->cam_cy) * follow;
+
+    if (max_spd < 1.0f) max_spd = 1.0f;
+    ctx->smooth_max_spd += (max_spd - ctx->smooth_max_spd) * follow;
+    for (int g = 0; g < num_groups; g++) {
+        float m = (group_max_spd[g] < 1.0f) ? 1.0f : group_max_spd[g];
+        groups[g].smooth_max_spd += (m - groups[g].smooth_max_spd) * follow;
+    }
+
+    // --- DENSITY GRID EXPORT ---
+    // Bounds are fixed at the start of each segment so accumulated frames line up
+    if (ctx->volume_prefix) {
+        if (ctx->volume_accum_frames == 0) {
+            ctx->volume_bounds = compute_particle_bounds(h_x, h_y, h_z, num_particles, sample_stride);
+            ctx->volume_first_frame = frame;
+        }
+        splat_density_grid(h_x, h_y, h_z, num_particles, ctx->volume_grid, cfg_volume_res, ctx->volume_bounds);
+        if (++ctx->volume_accum_frames == cfg_volume_frames) {
+            export_density_volume(ctx->volume_prefix, ctx->volume_index++, ctx->volume_grid, cfg_volume_res,
+                                  ctx->volume_bounds, ctx->volume_first_frame, ctx->volume_accum_frames,
+                                  cfg_volume_sparse);
+            ctx->volume_accum_frames = 0;
+        }
+    }
+
+    // --- POINT CLOUD EXPORT ---
+    if (ctx->ply_prefix && (ctx->ply_requested || (cfg_ply_interval > 0 && frame % cfg_ply_interval == 0))) {
+        ctx->ply_requested = 0;
+        #pragma acc update self(h_x[0:num_particles], h_y[0:num_particles], h_z[0:num_particles], \
+                                h_vx[0:num_particles], h_vy[0:num_particles], h_vz[0:num_particles])
+        export_point_cloud(ctx->ply_prefix, ctx->ply_index++, frame, current_type, num_particles,
+                           cfg_ply_decimate, cfg_ply_stratified, h_x, h_y, h_z, h_vx, h_vy, h_vz);
+    }
+
+    ctx->frame++;
+}
+
+// 3x3 tent filter (1-2-1 per axis, edges clamped) of an RGB float image
+static void blur_tent(const float *src, float *dst, int w, int h) {
+    #pragma acc parallel loop present(src, dst)
+    for (int y = 0; y < h; y++) {
+        const float *rm = &src[(y > 0 ? y - 1 : y) * w * 3], *r0 = &src[y * w * 3];
+        const float *rp = &src[(y + 1 < h ? y + 1 : y) * w * 3];
+        #pragma acc loop vector
+        for (int x = 0; x < w; x++) {
+            int xm = (x > 0 ? x - 1 : x) * 3, x0 = x * 3, xp = (x + 1 < w ? x + 1 : x) * 3;
+            for (int c = 0; c < 3; c++) {
+                float top = rm[xm + c] + 2.0f * rm[x0 + c] + rm[xp + c];
+                float mid = r0[xm + c] + 2.0f * r0[x0 + c] + r0[xp + c];
+                float bot = rp[xm + c] + 2.0f * rp[x0 + c] + rp[xp + c];
+                dst[(y * w + x) * 3 + c] = (top + 2.0f * mid + bot) * (1.0f / 16.0f);
+            }
+        }
+    }
+}
+
+// 2x bilinear RGB24 upscale (pixel centers aligned, edges clamped), for proxy
+// frames. Each output pixel mixes its nearest source pixel and the neighbours
+// toward it with fixed 3/4, 1/4 weights per axis, in integer arithmetic.
+static void upscale_2x(const unsigned char *src, int sw, int sh, unsigned char *dst, int dw, int dh) {
+    #pragma acc parallel loop present(src, dst)
+    for (int y = 0; y < dh; y++) {
+        int y0 = y / 2 < sh ? y / 2 : sh - 1;
+        int y1 = (y & 1) ? y0 + 1 : y0 - 1;
+        if (y1 < 0) y1 = 0;
+        if (y1 >= sh) y1 = sh - 1;
+        const unsigned char *r0 = &src[y0 * sw * 3], *r1 = &src[y1 * sw * 3];
+        #pragma acc loop vector
+        for (int x = 0; x < dw; x++) {
+            int x0 = x / 2 < sw ? x / 2 : sw - 1;
+            int x1 = (x & 1) ? x0 + 1 : x0 - 1;
+            if (x1 < 0) x1 = 0;
+            if (x1 >= sw) x1 = sw - 1;
+            for (int c = 0; c < 3; c++) {
+                int v = 9 * r0[x0 * 3 + c] + 3 * (r0[x1 * 3 + c] + r1[x0 * 3 + c]) + r1[x1 * 3 + c];
+                dst[(y * dw + x) * 3 + c] = (unsigned char)((v + 8) >> 4);
+            }
+        }
+    }
+}
+
+// Log tone map of linear radiance to RGB24
+static void tone_map(const float *src, unsigned char *dst, int pixels, float exposure) {
+    #pragma acc parallel loop present(src, dst)
+    for (int i = 0; i < pixels; i++) {
+        int idx = i * 3;
+        float r = src[idx+0];
+        float g = src[idx+1];
+        float b = src[idx+2];
+
+        r = logf(1.0f + r * exposure) * 45.0f;
+        g = logf(1.0f + g * exposure) * 45.0f;
+        b = logf(1.0f + b * exposure) * 45.0f;
+
+        if (r > 255) r = 255; if (g > 255) g = 255; if (b > 255) b = 255;
+
+        dst[idx+0] = (unsigned char)r;
+        dst[idx+1] = (unsigned char)g;
+        dst[idx+2] = (unsigned char)b;
+    }
+}
+
+// Part of a frame that a render covers: the accum is width x height pixels
+// starting at (x0, y0) of a frame_width x frame_height frame centered on the
+// camera. Tiles project exactly as the whole frame would, so they meet
+// without seams.
+typedef struct {
+    int x0, y0, width, height;
+    int frame_width, frame_height;
+} Viewport;
+
+// Point splatting of the current particles (and their symmetry images) into
+// accum, colored by speed, ensemble coordinate or occupancy density.
+// A hashed half of the particles goes to odd_accum, which may be accum itself
+// (splitting by index parity would not be fair: consecutive low-discrepancy
+// points start in opposite halves of the box, and so can settle in different
+// basins).
+static void render_points(ac_context *ctx, float *accum_buffer, float *odd_accum, const Viewport *vp,
+                          float cos_t, float sin_t, float cam_cx, float cam_cy, float cam_scale) {
+    int width = vp->width, height = vp->height, x0 = vp->x0, y0 = vp->y0;
+    int half_w = vp->frame_width / 2, half_h = vp->frame_height / 2;
+    int num_particles = ctx->num_particles, num_groups = ctx->num_groups;
+    int sample_stride = STATS_STRIDE / ctx->id_stride;
+    float *h_x = ctx->h_x, *h_y = ctx->h_y, *h_z = ctx->h_z, *h_w = ctx->h_w;
+    float *h_vx = ctx->h_vx, *h_vy = ctx->h_vy, *h_vz = ctx->h_vz;
+    float *frame_depth = ctx->frame_depth, *occupancy = ctx->occupancy;
+    const Group *groups = ctx->groups;
+    int temporal = ctx->temporal, hyper_view = ctx->hyper_view;
+    float cos_h = ctx->cos_h, sin_h = ctx->sin_h;
+    int split = odd_accum != accum_buffer;
+
+    // Histogram pass for density coloring
+    int color_mode = ctx->color_mode, occ_res = ctx->occ_res;
+    float color_density_mix = ctx->color_density_mix;
+    float occ_min_x = 0.0f, occ_min_y = 0.0f, occ_min_z = 0.0f;
+    float occ_sx = 0.0f, occ_sy = 0.0f, occ_sz = 0.0f, occ_inv_log_max = 0.0f;
+    if (color_mode != COLOR_SPEED) {
+        Bounds *occ_bounds = &ctx->occ_bounds;
+        size_t occ_cells = ctx->occ_cells;
+        track_bounds(occ_bounds, compute_particle_bounds(h_x, h_y, h_z, num_particles, sample_stride), 0.05f);
+        #pragma acc parallel loop present(occupancy)
+        for (size_t c = 0; c < occ_cells; c++) occupancy[c] = 0.0f;
+        splat_density_grid(h_x, h_y, h_z, num_particles, occupancy, occ_res, *occ_bounds);
+
+        occ_min_x = occ_bounds->min_x; occ_min_y = occ_bounds->min_y; occ_min_z = occ_bounds->min_z;
+        occ_sx = occ_res / (occ_bounds->max_x - occ_bounds->min_x);
+        occ_sy = occ_res / (occ_bounds->max_y - occ_bounds->min_y);
+        occ_sz = occ_res / (occ_bounds->max_z - occ_bounds->min_z);
+        occ_inv_log_max = 1.0f / logf(2.0f + grid_max(occupancy, occ_cells));
+    }
+
+    // All groups in one pass; the group is found from the index ranges
+    #pragma acc parallel loop present(h_x, h_y, h_z, h_w, h_vx, h_vy, h_vz, accum_buffer, odd_accum, occupancy, \
+                                      frame_depth) copyin(groups[0:num_groups])
+    for (int i = 0; i < num_particles; i++) {
+        float x = h_x[i]; float y = h_y[i]; float z = h_z[i];
+        float *accum = (split && hash_unit((uint32_t)i) < 0.5f) ? odd_accum : accum_buffer;
+        int grp = 0;
+        while (grp < num_groups - 1 && i >= groups[grp].end) grp++;
+        float ox = groups[grp].ox, oy = groups[grp].oy, oz = groups[grp].oz;
+        int rotate = hyper_view && groups[grp].dims == 4;
+        float r = 0.0f, g = 0.0f, b = 0.0f;
+        int shaded = 0;
+
+        // Image 0 is the particle itself, the rest are its symmetry images
+        // (signed permutations about the group origin, weighted for blends)
+        for (int k = 0; k <= groups[grp].num_images; k++) {
+            float sx = x, sy = y, sz = z, sw = rotate ? h_w[i] : 0.0f, weight = 1.0f;
+            if (k > 0) {
+                const SymImage *im = &groups[grp].images[k - 1];
+                float lx = x - ox, ly = y - oy, lz = z - oz;
+                sx = ox + im->m[0] * lx + im->m[1] * ly + im->m[2] * lz;
+                sy = oy + im->m[3] * lx + im->m[4] * ly + im->m[5] * lz;
+                sz = oz + im->m[6] * lx + im->m[7] * ly + im->m[8] * lz;
+                sw *= im->w_sign;
+                weight = im->weight;
+            }
+
+            // 4D: rotate in the x-w plane (about the group origin) first, then orbit about Y as usual
+            float vx = rotate ? ox + (sx - ox) * cos_h - sw * groups[grp].scale * sin_h : sx;
+            float rx = vx * cos_t - sz * sin_t;
+            float rz = vx * sin_t + sz * cos_t;
+            float ry = sy;
+
+            // Orthographic projection - direct scaling without perspective division
+            // cam_scale now directly controls pixels per unit
+            int px = (int)((rx - cam_cx) * cam_scale + half_w) - x0;
+            int py = (int)((ry - cam_cy) * cam_scale + half_h) - y0;
+
+            if (px >= 0 && px < width && py >= 0 && py < height) {
+                // Color depends only on the integrated particle; shade once for all images
+                if (!shaded) {
+                    float spd = sqrtf(h_vx[i]*h_vx[i] + h_vy[i]*h_vy[i] + h_vz[i]*h_vz[i]);
+                    float t = spd / groups[grp].smooth_max_spd;
+                    // Ensemble members are colored by their parameter offset
+                    if (groups[grp].ensemble) {
+                        int id = particle_id(i, groups[grp].id_stride, groups[grp].id_begin + groups[grp].id_count);
+                        t = ensemble_coord(id, groups[grp].id_begin, 1.0f / groups[grp].id_count);
+                    }
+
+                    // Log-scaled density of the particle's occupancy cell
+                    if (color_mode != COLOR_SPEED) {
+                        float td = 0.0f;
+                        float fx = (x - occ_min_x) * occ_sx;
+                        float fy = (y - occ_min_y) * occ_sy;
+                        float fz = (z - occ_min_z) * occ_sz;
+                        if (fx >= 0.0f && fx < occ_res && fy >= 0.0f && fy < occ_res && fz >= 0.0f && fz < occ_res) {
+                            td = logf(1.0f + occupancy[((int)fz * occ_res + (int)fy) * occ_res + (int)fx]) * occ_inv_log_max;
+                        }
+                        t = (color_mode == COLOR_DENSITY) ? td : t + (td - t) * color_density_mix;
+                    }
+
+                    get_palette_color(groups[grp].palette, t, &r, &g, &b);
+                    shaded = 1;
+                }
+
+                // Simplified fade based on depth for visual interest only (not projection)
+                float depth_fade = 1.0f / (1.0f + fabsf(rz) * 0.01f);  // Slight fade for far particles
+
+                int idx = (py * width + px) * 3;
+                #pragma acc atomic update
+                accum[idx+0] += r * depth_fade * weight;
+                #pragma acc atomic update
+                accum[idx+1] += g * depth_fade * weight;
+                #pragma acc atomic update
+                accum[idx+2] += b * depth_fade * weight;
+                if (temporal) {
+                    #pragma acc atomic update
+                    frame_depth[py * width + px] += rz * (r + g + b) * depth_fade * weight;
+                }
+            }
+        }
+    }
+}
+
+void ac_render(ac_context *ctx, unsigned char *rgb) {
+    // Paused: hold the last frame (map modes clear their hits when resolved)
+    if (ctx->paused && ctx->frames_rendered > 0) {
+        if (rgb) memcpy(rgb, ctx->out_buffer, (size_t)ctx->width * ctx->height * 3);
+        return;
+    }
+    int run_mode = ctx->mode, width = ctx->render_width, height = ctx->render_height;
+    int num_particles = ctx->num_particles;
+    int sample_stride = STATS_STRIDE / ctx->id_stride;
+    float *h_x = ctx->h_x, *h_y = ctx->h_y, *h_z = ctx->h_z;
+    float *h_vx = ctx->h_vx, *h_vy = ctx->h_vy, *h_vz = ctx->h_vz;
+    float *accum_buffer = ctx->accum_buffer, *frame_depth = ctx->frame_depth;
+    unsigned char *out_buffer = ctx->proxy_rgb ? ctx->proxy_rgb : ctx->out_buffer;
+    int temporal = ctx->temporal;
+    float cos_t = cosf(ctx->theta), sin_t = sinf(ctx->theta);
+    float cam_cx = ctx->cam_cx, cam_cy = ctx->cam_cy, cam_scale = ctx->cam_scale * ctx->render_scale;
+
+    #pragma acc parallel loop present(accum_buffer)
+    for(int i=0; i<width*height*3; i++) accum_buffer[i] = 0.0f;
+    if (temporal) {
+        #pragma acc parallel loop present(frame_depth)
+        for (int i = 0; i < width * height; i++) frame_depth[i] = 0.0f;
+    }
+
+    // --- RENDER ---
+    if (run_mode == MODE_MAP || run_mode == MODE_IFS) {
+        resolve_map_hits(ctx->map_hits, ctx->map_color, accum_buffer, width, height, 1.0f / cfg_map_iterations, 1);
+    } else if (run_mode == MODE_BIFURCATION) {
+        // The diagram keeps accumulating; normalize so a column spread evenly
+        // over the full height sits at about 2 splats per pixel
+        float plotted = (float)ctx->bif_per_col * ctx->bif_plotted_steps * (cfg_bif_maxima ? 0.1f : 1.0f);
+        resolve_map_hits(ctx->map_hits, ctx->map_color, accum_buffer, width, height, 2.0f * height / plotted, 0);
+    } else if (cfg_render_mode == RENDER_VOLUME) {
+        track_bounds(&ctx->march_bounds, compute_particle_bounds(h_x, h_y, h_z, num_particles, sample_stride), 0.05f);
+        splat_emission_grid(h_x, h_y, h_z, h_vx, h_vy, h_vz, num_particles,
+                            ctx->march_density, ctx->march_speed, cfg_march_res, ctx->march_bounds);
+        raymarch_volume(ctx->march_density, ctx->march_speed, cfg_march_res, ctx->march_bounds, accum_buffer,
+                        width, height, cos_t, sin_t, cam_cx, cam_cy, cam_scale, ctx->smooth_max_spd,
+                        cfg_march_steps, cfg_march_absorption);
+    } else if (cfg_render_mode == RENDER_TRAILS) {
+        render_trails(ctx->trail_x, ctx->trail_y, ctx->trail_z, num_particles, ctx->trail_len, ctx->trail_head,
+                      accum_buffer, width, height, cos_t, sin_t, cam_cx, cam_cy, cam_scale, ctx->smooth_max_spd);
+    } else {
+        Viewport vp = { 0, 0, width, height, width, height };
+        render_points(ctx, accum_buffer, accum_buffer, &vp, cos_t, sin_t, cam_cx, cam_cy, cam_scale);
+    }
+
+    // --- TEMPORAL ACCUMULATION ---
+    if (temporal) {
+        ViewState view = {ctx->theta, cam_cx, cam_cy, cam_scale};
+        // A type switch invalidates everything; during its blend history is
+        // rejected more eagerly
+        float transition_blend = ctx->transition_blend;
+        int cap = (transition_blend < 1.0f && ctx->prev_blend >= 1.0f) ? 0 : ctx->temporal_frames;
+        float reject = cfg_temporal_reject * (transition_blend < 1.0f ? 0.5f + 0.5f * transition_blend : 1.0f);
+        int h = ctx->history_cur;
+        temporal_resolve(accum_buffer, frame_depth, ctx->history_rgb[h], ctx->history_n[h], ctx->history_depth[h],
+                         ctx->history_rgb[h ^ 1], ctx->history_n[h ^ 1], ctx->history_depth[h ^ 1], width, height,
+                         ctx->frames_rendered == 0 ? view : ctx->prev_view, view, ctx->temporal_frames, cap, reject);
+        ctx->history_cur = h ^ 1;
+        ctx->prev_view = view;
+    }
+
+    // --- DENOISE ---
+    float *tone_src = accum_buffer;
+    if (cfg_denoise) {
+        denoise_bilateral(accum_buffer, ctx->denoise_guide, ctx->denoise_buffer, width, height,
+                          cfg_denoise_radius, cfg_denoise_sigma_s, cfg_denoise_sigma_r);
+        tone_src = ctx->denoise_buffer;
+    }
+    // A proxy has 1/5 the splats per pixel; under the log tone map those sparse
+    // splats come out about half as bright as the full render, so spread each
+    // over its neighbours first
+    if (ctx->proxy_accum) {
+        blur_tent(tone_src, ctx->proxy_accum, width, height);
+        tone_src = ctx->proxy_accum;
+    }
+
+    // --- TONE MAP ---
+    tone_map(tone_src, out_buffer, width * height, EXPOSURE * ctx->density_comp * ctx->exposure);
+
+    // --- PROXY UPSCALE ---
+    out_buffer = ctx->out_buffer;
+    width = ctx->width;
+    height = ctx->height;
+    if (ctx->proxy_rgb) upscale_2x(ctx->proxy_rgb, ctx->render_width, ctx->render_height, out_buffer, width, height);
+
+    ctx->noise = cfg_noise_metric ? measure_noise(out_buffer, width, height) : 0.0f;
+    ctx->noise_total += ctx->noise;
+    ctx->frames_rendered++;
+
+    #pragma acc update self(out_buffer[0:width*height*3])
+    if (rgb) memcpy(rgb, out_buffer, (size_t)width * height * 3);
+}
+
+void ac_get_stats(const ac_context *ctx, ac_stats *stats) {
+    stats->frame = ctx->frame;
+    stats->current_type = ctx->current_type;
+    stats->previous_type = ctx->previous_type;
+    stats->transition_blend = ctx->transition_blend;
+    stats->cam_scale = ctx->cam_scale;
+    stats->cam_cx = ctx->cam_cx;
+    stats->cam_cy = ctx->cam_cy;
+    stats->noise_metric = cfg_noise_metric;
+    stats->noise = ctx->noise;
+    stats->mean_noise = ctx->frames_rendered > 0 ? ctx->noise_total / ctx->frames_rendered : 0.0;
+    stats->frames_rendered = ctx->frames_rendered;
+    stats->num_particles = ctx->num_particles;
+    stats->width = ctx->width;
+    stats->height = ctx->height;
+    stats->volumes_written = ctx->volume_index;
+    stats->clouds_written = ctx->ply_index;
+}
+
+void ac_get_buffers(ac_context *ctx, ac_buffers *buf) {
+    if (!ctx->speed) {
+        int n = ctx->alloc_particles;
+        float *speed = (float*)calloc(n, sizeof(float));
+        if (speed) {
+            #pragma acc enter data copyin(speed[0:n])
+        } else {
+            fprintf(stderr, "Warning: out of memory for the speed view\n");
+        }
+        ctx->speed = speed;
+    }
+    buf->x = ctx->h_x; buf->y = ctx->h_y; buf->z = ctx->h_z;
+    buf->vx = ctx->h_vx; buf->vy = ctx->h_vy; buf->vz = ctx->h_vz;
+    buf->speed = ctx->speed;
+    buf->accum = ctx->accum_buffer;
+    buf->frame = ctx->out_buffer;
+    buf->num_particles = ctx->num_particles;
+    buf->width = ctx->width;
+    buf->height = ctx->height;
+    buf->accum_width = ctx->render_width;
+    buf->accum_height = ctx->render_height;
+}
+
+void ac_sync_host(ac_context *ctx) {
+    int n = ctx->num_particles;
+    float *h_vx = ctx->h_vx, *h_vy = ctx->h_vy, *h_vz = ctx->h_vz, *speed = ctx->speed;
+    if (speed) {
+        #pragma acc parallel loop present(h_vx, h_vy, h_vz, speed)
+        for (int i = 0; i < n; i++) speed[i] = sqrtf(h_vx[i]*h_vx[i] + h_vy[i]*h_vy[i] + h_vz[i]*h_vz[i]);
+        acc_update_self(speed, n * sizeof(float));
+    }
+    float *particles[] = {ctx->h_x, ctx->h_y, ctx->h_z, h_vx, h_vy, h_vz};
+    for (int c = 0; c < 6; c++) acc_update_self(particles[c], n * sizeof(float));
+    acc_update_self(ctx->accum_buffer, (size_t)ctx->render_width * ctx->render_height * 3 * sizeof(float));
+}
+
+void ac_sync_device(ac_context *ctx) {
+    int n = ctx->num_particles;
+    float *particles[] = {ctx->h_x, ctx->h_y, ctx->h_z, ctx->h_vx, ctx->h_vy, ctx->h_vz};
+    for (int c = 0; c < 6; c++) acc_update_device(particles[c], n * sizeof(float));
+    // Reduced-rate physics integrates the key state, so edits restart from it
+    for (int c = 0; c < 3 && ctx->interp; c++) {
+        float *src = ctx->display[c], *dst = ctx->key1[c];
+        #pragma acc parallel loop present(src, dst)
+        for (int i = 0; i < n; i++) dst[i] = src[i];
+    }
+}
+
+void ac_request_point_cloud(ac_context *ctx) {
+    ctx->ply_requested = 1;
+}
+
+void ac_flush(ac_context *ctx) {
+    // Flush a partially accumulated volume segment
+    if (ctx->volume_prefix && ctx->volume_accum_frames > 0) {
+        export_density_volume(ctx->volume_prefix, ctx->volume_index++, ctx->volume_grid, cfg_volume_res,
+                              ctx->volume_bounds, ctx->volume_first_frame, ctx->volume_accum_frames,
+                              cfg_volume_sparse);
+        ctx->volume_accum_frames = 0;
+    }
+    if (ctx->writing) writer_drain();
+}
+
+// Release a buffer's device copy, then the buffer. A context that failed
+// part-way through ac_create can hold buffers never copied to the device.
+static void free_device(void *p, size_t bytes) {
+    if (!p) return;
+    if (acc_is_present(p, bytes)) acc_delete(p, bytes);
+    free(p);
+}
+
+void ac_destroy(ac_context *ctx) {
+    if (!ctx) return;
+    ac_flush(ctx);
+    if (ctx->writing) writer_stop();
+    if (ctx->log_file) fclose(ctx->log_file);
+
+    size_t n = ctx->alloc_particles, pixels = (size_t)ctx->render_width * ctx->render_height;
+    float *particles[] = {ctx->h_x, ctx->h_y, ctx->h_z, ctx->h_vx, ctx->h_vy, ctx->h_vz};
+    for (int c = 0; c < 6; c++) free_device(particles[c], n * sizeof(float));
+    free_device(ctx->h_w, ctx->w_cells * sizeof(float));
+    free_device(ctx->h_vw, ctx->w_cells * sizeof(float));
+    free_device(ctx->accum_buffer, pixels * 3 * sizeof(float));
+    free_device(ctx->out_buffer, (size_t)ctx->width * ctx->height * 3);
+    free_device(ctx->proxy_accum, pixels * 3 * sizeof(float));
+    free_device(ctx->proxy_rgb, pixels * 3);
+    free_device(ctx->frame_depth, ctx->history_cells * sizeof(float));
+    for (int h = 0; h < 2; h++) {
+        free_device(ctx->history_rgb[h], ctx->history_cells * 3 * sizeof(float));
+        free_device(ctx->history_n[h], ctx->history_cells * sizeof(float));
+        free_device(ctx->history_depth[h], ctx->history_cells * sizeof(float));
+    }
+    for (int c = 0; c < KEY_COMPONENTS; c++) {
+        free_device(ctx->key0[c], n * sizeof(float));
+        if (c < 4) free_device(ctx->key1[c], n * sizeof(float));
+    }
+    free_device(ctx->trail_x, ctx->trail_cells * sizeof(int16_t));
+    free_device(ctx->trail_y, ctx->trail_cells * sizeof(int16_t));
+    free_device(ctx->trail_z, ctx->trail_cells * sizeof(int16_t));
+    free_device(ctx->occupancy, ctx->occ_cells * sizeof(float));
+    free_device(ctx->march_density, ctx->march_cells * sizeof(float));
+    free_device(ctx->march_speed, ctx->march_cells * sizeof(float));
+    free_device(ctx->map_hits, pixels * sizeof(uint32_t));
+    free_device(ctx->map_color, pixels * sizeof(float));
+    free_device(ctx->volume_grid, ctx->volume_cells * sizeof(float));
+    free_device(ctx->denoise_guide, pixels * sizeof(float));
+    free_device(ctx->denoise_buffer, pixels * 3 * sizeof(float));
+    free_device(ctx->speed, n * sizeof(float));
+    free(ctx->volume_prefix); free(ctx->ply_prefix);
+    free(ctx);
+}
+
+// --- Long-Exposure Still ---
+static double wall_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Error estimate of a still from its two independent halves of particles:
+// RMS difference of their tone-mapped luma over lit pixels, halved for the
+// error of the combined mean. Compared before 8-bit rounding, which would put
+// a floor under it.
+static float split_noise(const float *even, const float *odd, float exposure, int pixels) {
+    double sum = 0.0;
+    long count = 0;
+    #pragma acc parallel loop present(even, odd) reduction(+:sum, count)
+    for (int i = 0; i < pixels; i++) {
+        float la = 0.0f, lb = 0.0f, lc = 0.0f;
+        for (int k = 0; k < 3; k++) {
+            float w = (k == 0) ? 0.299f : (k == 1) ? 0.587f : 0.114f;
+            la += w * fminf(logf(1.0f + 2.0f * even[i*3+k] * exposure) * 45.0f, 255.0f);
+            lb += w * fminf(logf(1.0f + 2.0f * odd[i*3+k] * exposure) * 45.0f, 255.0f);
+            lc += w * fminf(logf(1.0f + (even[i*3+k] + odd[i*3+k]) * exposure) * 45.0f, 255.0f);
+        }
+        if (lc >= 2.0f) {  // Background is not noise
+            sum += (la - lb) * (la - lb);
+            count++;
+        }
+    }
+    return count > 0 ? 0.5f * (float)sqrt(sum / count) : 0.0f;
+}
+
+static int write_ppm(const char *path, const unsigned char *rgb, int width, int height) {
+    FILE *f = path ? fopen(path, "wb") : stdout;
+    if (!f) return 0;
+    fprintf(f, "P6\n%d %d\n255\n", width, height);
+    int ok = fwrite(rgb, 1, (size_t)width * height * 3, f) == (size_t)width * height * 3;
+    if (path) ok = (fclose(f) == 0) && ok;
+    else fflush(f);
+    return ok;
+}
+
+// Flow context for a still, warmed up as an animation with a fast camera
+static ac_context *still_context(const ac_options *opt) {
+    ac_options o = *opt;
+    o.mode = MODE_FLOW;
+    o.proxy = 0;
+    o.frames_per_fragment = cfg_still_warmup + 1;  // No type switch before the shutter opens
+    o.chapter_log = o.volume_prefix = o.ply_prefix = NULL;
+    o.physics_interval = 1;                       // Every step is exposed
+    o.temporal_frames = 0;
+    ac_context *ctx = ac_create(&o);
+    if (!ctx) return NULL;
+
+    ctx->cam_follow = STILL_FOLLOW;
+    for (int f = 0; f < cfg_still_warmup; f++) ac_step(ctx);
+    return ctx;
+}
+
+// One exposed step: integrate every group with params and blend frozen
+static void still_integrate(ac_context *ctx) {
+    float **state = ctx->display;
+    for (int g = 0; g < ctx->num_groups; g++) {
+        if (ctx->groups[g].dims == 4) {
+            integrate_flow_4d(state[0], state[1], state[2], state[3], state[4], state[5], state[6], state[7],
+                              ctx->num_particles, ctx->groups[g], ctx->transition_blend, DT, ctx->sampler,
+                              ctx->trail_x, ctx->trail_y, ctx->trail_z, 0, 0);
+        } else {
+            integrate_flow_3d(state[0], state[1], state[2], state[4], state[5], state[6],
+                              ctx->num_particles, ctx->groups[g], ctx->transition_blend, DT, ctx->sampler,
+                              ctx->trail_x, ctx->trail_y, ctx->trail_z, 0, 0);
+        }
+    }
+    ctx->sampler.round++;
+}
+
+// After the warm-up, freeze params, blend, view and camera and keep
+// integrating. Every step is splatted without clearing, two hashed halves of
+// the particles into separate buffers. Every still_preview_every steps those
+// are folded into float sums (so no buffer takes more than one interval of
+// small adds), the total is tone mapped at the mean exposure per step, and
+// the two independent halves give the noise estimate.
+int ac_run_still(const ac_options *opt, const char *preview_path) {
+    if (cfg_render_mode != RENDER_POINTS) {
+        fprintf(stderr, "Error: still mode needs render_mode=0 (point splatting)\n");
+        return 1;
+    }
+    if (cfg_still_steps == 0 && cfg_still_seconds <= 0.0f && cfg_still_noise <= 0.0f) {
+        fprintf(stderr, "Error: still mode needs still_steps, still_seconds or still_noise\n");
+        return 1;
+    }
+    ac_context *ctx = still_context(opt);
+    if (!ctx) return 1;
+
+    int width = ctx->width, height = ctx->height, pixels = width * height;
+    int num_particles = ctx->num_particles;
+    float *accum_buffer = ctx->accum_buffer;
+    unsigned char *out_buffer = ctx->out_buffer;
+    size_t plane = (size_t)pixels * 3;
+    float *odd_accum = (float*)malloc(plane * sizeof(float));
+    float *even_sum = (float*)malloc(plane * sizeof(float));
+    float *odd_sum = (float*)malloc(plane * sizeof(float));
+    if (!odd_accum || !even_sum || !odd_sum) {
+        fprintf(stderr, "Error: out of memory for the still buffers\n");
+        free(odd_accum);
+        free(even_sum);
+        free(odd_sum);
+        ac_destroy(ctx);
+        return 1;
+    }
+    #pragma acc enter data create(odd_accum[0:plane], even_sum[0:plane], odd_sum[0:plane])
+    #pragma acc parallel loop present(accum_buffer, odd_accum, even_sum, odd_sum)
+    for (size_t i = 0; i < plane; i++) accum_buffer[i] = odd_accum[i] = even_sum[i] = odd_sum[i] = 0.0f;
+
+    float cos_t = cosf(ctx->theta), sin_t = sinf(ctx->theta);
+    Viewport vp = { 0, 0, width, height, width, height };
+    fprintf(stderr, "Still: type %d, %dx%d, %d particles, camera scale %.1f\n",
+            ctx->current_type, width, height, num_particles, ctx->cam_scale);
+
+    double start = wall_seconds();
+    float noise = 0.0f;
+    int steps = 0, done = 0;
+    while (!done) {
+        still_integrate(ctx);
+        render_points(ctx, accum_buffer, odd_accum, &vp, cos_t, sin_t, ctx->cam_cx, ctx->cam_cy, ctx->cam_scale);
+        steps++;
+
+        double elapsed = wall_seconds() - start;
+        int limit = (cfg_still_steps > 0 && steps >= cfg_still_steps) ||
+                    (cfg_still_seconds > 0.0f && elapsed >= cfg_still_seconds);
+        if (steps % cfg_still_preview_every != 0 && !limit) continue;
+
+        // Fold the interval in; odd_accum holds the total while it is tone mapped
+        #pragma acc parallel loop present(accum_buffer, odd_accum, even_sum, odd_sum)
+        for (size_t i = 0; i < plane; i++) {
+            even_sum[i] += accum_buffer[i];
+            odd_sum[i] += odd_accum[i];
+            accum_buffer[i] = 0.0f;
+            odd_accum[i] = even_sum[i] + odd_sum[i];
+        }
+        float exposure = EXPOSURE / steps;
+        tone_map(odd_accum, out_buffer, pixels, exposure);
+        noise = split_noise(even_sum, odd_sum, exposure, pixels);
+        #pragma acc parallel loop present(odd_accum)
+        for (size_t i = 0; i < plane; i++) odd_accum[i] = 0.0f;
+        done = limit || (cfg_still_noise > 0.0f && noise < cfg_still_noise);
+
+        if (preview_path || done) {
+            #pragma acc update self(out_buffer[0:plane])
+        }
+        if (preview_path) {
+            // Write beside the preview and rename, so viewers never see a partial file
+            size_t len = strlen(preview_path) + 5;
+            char *tmp = (char*)malloc(len);
+            if (tmp) snprintf(tmp, len, "%s.tmp", preview_path);
+            if (!tmp || !write_ppm(tmp, out_buffer, width, height) || rename(tmp, preview_path) != 0) {
+                fprintf(stderr, "\nWarning: could not write preview '%s'\n", preview_path);
+            }
+            free(tmp);
+        }
+        fprintf(stderr, "Still: %d steps | %.2fG samples | %.0f s | noise %.2f\r",
+                steps, (double)steps * num_particles * 1e-9, elapsed, noise);
+    }
+    fprintf(stderr, "\n");
+
+    int ok = write_ppm(NULL, out_buffer, width, height);
+    free_device(odd_accum, plane * sizeof(float));
+    free_device(even_sum, plane * sizeof(float));
+    free_device(odd_sum, plane * sizeof(float));
+    ac_destroy(ctx);
+    return ok ? 0 : 1;
+}
+
+// Still larger than one render buffer, streamed to a tiled TIFF. The scene
+// warms up at a preview size of the same aspect (at most 1920x1080) and the
+// camera scale is multiplied up to the full width, so the framing matches a
+// small still. The particle state at shutter open is kept on the device and
+// every tile re-runs the same still_steps steps from it, splatting only its
+// own window; tiles are therefore exact crops of one exposure. Memory is one
+// tile plus the writer queue, whatever the output size; each tile costs a
+// full exposure of simulation.
+int ac_run_still_tiled(const ac_options *opt, const char *tiff_path) {
+    if (cfg_render_mode != RENDER_POINTS) {
+        fprintf(stderr, "Error: still mode needs render_mode=0 (point splatting)\n");
+        return 1;
+    }
+    if (cfg_still_steps == 0) {
+        fprintf(stderr, "Error: tiled stills need still_steps (every tile gets the same exposure)\n");
+        return 1;
+    }
+    int out_width = opt->width, out_height = opt->height, tile = cfg_still_tile;
+    float fit = fminf(1.0f, fminf(1920.0f / out_width, 1080.0f / out_height));
+    ac_options o = *opt;
+    o.width = (int)fmaxf(16.0f, out_width * fit);
+    o.height = (int)fmaxf(16.0f, out_height * fit);
+    ac_context *ctx = still_context(&o);
+    if (!ctx) return 1;
+
+    TiffFile *tiff = tiff_open(tiff_path, out_width, out_height, tile);
+    if (!tiff) {
+        fprintf(stderr, "Error: could not open '%s' for writing\n", tiff_path);
+        ac_destroy(ctx);
+        return 1;
+    }
+
+    int n = ctx->num_particles;
+    size_t state_size = (size_t)KEY_COMPONENTS * n;
+    size_t plane = (size_t)tile * tile * 3;
+    float *snapshot = (float*)malloc(state_size * sizeof(float));
+    float *tile_accum = (float*)malloc(plane * sizeof(float));
+    unsigned char *tile_rgb = (unsigned char*)malloc(plane);
+    if (!snapshot || !tile_accum || !tile_rgb) {
+        fprintf(stderr, "Error: out of memory for the still tiles\n");
+        tiff_close(tiff);
+        free(snapshot);
+        free(tile_accum);
+        free(tile_rgb);
+        ac_destroy(ctx);
+        return 1;
+    }
+    #pragma acc enter data create(snapshot[0:state_size], tile_accum[0:plane], tile_rgb[0:plane])
+    for (int c = 0; c < KEY_COMPONENTS; c++) {
+        float *src = ctx->display[c], *dst = snapshot + (size_t)c * n;
+        #pragma acc parallel loop present(src, dst)
+        for (int i = 0; i < n; i++) dst[i] = src[i];
+    }
+    Bounds occ_bounds = ctx->occ_bounds;
+    uint32_t sampler_round = ctx->sampler.round;
+
+    float cos_t = cosf(ctx->theta), sin_t = sinf(ctx->theta);
+    float cam_scale = ctx->cam_scale * out_width / ctx->width;
+    int tiles_x = (out_width + tile - 1) / tile, tiles_y = (out_height + tile - 1) / tile;
+    fprintf(stderr, "Still: type %d, %dx%d in %d %dx%d tiles, %d particles, camera scale %.1f%s\n",
+            ctx->current_type, out_width, out_height, tiles_x * tiles_y, tile, tile, n, cam_scale,
+            tiff->big ? ", BigTIFF" : "");
+
+    writer_start();
+    double start = wall_seconds();
+    int failed = 0;
+    for (int t = 0; t < tiles_x * tiles_y; t++) {
+        Viewport vp = { (t % tiles_x) * tile, (t / tiles_x) * tile, 0, 0, out_width, out_height };
+        vp.width = (out_width - vp.x0 < tile) ? out_width - vp.x0 : tile;
+        vp.height = (out_height - vp.y0 < tile) ? out_height - vp.y0 : tile;
+        size_t tile_values = (size_t)vp.width * vp.height * 3;
+
+        // Rewind to the shutter-open state
+        for (int c = 0; c < KEY_COMPONENTS; c++) {
+            float *src = snapshot + (size_t)c * n, *dst = ctx->display[c];
+            #pragma acc parallel loop present(src, dst)
+            for (int i = 0; i < n; i++) dst[i] = src[i];
+        }
+        ctx->occ_bounds = occ_bounds;
+        ctx->sampler.round = sampler_round;
+        #pragma acc parallel loop present(tile_accum)
+        for (size_t i = 0; i < tile_values; i++) tile_accum[i] = 0.0f;
+
+        for (int s = 0; s < cfg_still_steps; s++) {
+            still_integrate(ctx);
+            render_points(ctx, tile_accum, tile_accum, &vp, cos_t, sin_t, ctx->cam_cx, ctx->cam_cy, cam_scale);
+        }
+        tone_map(tile_accum, tile_rgb, vp.width * vp.height, EXPOSURE / cfg_still_steps);
+        #pragma acc update self(tile_rgb[0:tile_values])
+
+        // Edge tiles are padded with black to the full tile size
+        WriteJob job = { WRITE_TIFF_TILE };
+        job.tiff = tiff;
+        job.frame = t;
+        job.pixels = (unsigned char*)calloc(plane, 1);
+        if (!job.pixels) {
+            fprintf(stderr, "\nError: out of memory for tile %d\n", t);
+            failed = 1;
+            break;
+        }
+        for (int row = 0; row < vp.height; row++) {
+            memcpy(job.pixels + (size_t)row * tile * 3, tile_rgb + (size_t)row * vp.width * 3, (size_t)vp.width * 3);
+        }
+        writer_submit(&job);
+        fprintf(stderr, "Still: tile %d/%d | %.0f s\r", t + 1, tiles_x * tiles_y, wall_seconds() - start);
+    }
+    writer_stop();
+    fprintf(stderr, "\n");
+
+    int ok = tiff_close(tiff) && !failed;
+    if (!ok) fprintf(stderr, "Error: could not write '%s'\n", tiff_path);
+    free_device(tile_accum, plane * sizeof(float));
+    free_device(tile_rgb, plane);
+    free_device(snapshot, state_size * sizeof(float));
+    ac_destroy(ctx);
+    return ok ? 0 : 1;
+}
+
+int ac_run_lyapunov(int type, int width, int height) {
+    if (width < 16 || height < 16) return 1;
+    type = ((type % NUM_TYPES_3D) + NUM_TYPES_3D) % NUM_TYPES_3D;
+    return run_lyapunov_map(type, width, height);
+}
+
+int ac_run_calibration(void) {
+    return run_calibration();
+}
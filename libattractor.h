@@ -0,0 +1,158 @@
+#ifndef LIBATTRACTOR_H
+#define LIBATTRACTOR_H
+
+// libattractor: the attractor_cinematic engine behind a context API.
+//
+//   ac_options opt;
+//   ac_default_options(&opt);
+//   ac_context *ctx = ac_create(&opt);
+//   for (...) { ac_step(ctx); ac_render(ctx, rgb); }
+//   ac_destroy(ctx);
+//
+// Each context owns its particles, camera, transition state, random streams
+// and render buffers, so different contexts may step and render on different
+// threads at once. A single context is not thread-safe; drive it from one
+// thread at a time (ac_post_command excepted). Config keys (ac_configure /
+// ac_load_config / ac_reload_config) are process-wide and are also read while
+// contexts step, so change them only while no other thread is driving one.
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Run modes
+#define AC_MODE_FLOW 0                      // ODE attractor flows (default)
+#define AC_MODE_MAP 1                       // Iterated 2D strange maps
+#define AC_MODE_IFS 2                       // Chaos-game IFS / fractal flame
+#define AC_MODE_BIFURCATION 3               // Bifurcation diagram over one flow parameter
+#define AC_MODE_LYAPUNOV 4                  // Parameter-plane Lyapunov / basin still (ac_run_lyapunov)
+#define AC_MODE_CALIBRATE 5                 // Framing probe runs (ac_run_calibration)
+#define AC_MODE_STILL 6                     // Long-exposure flow still (ac_run_still)
+#define AC_NUM_MODES 7
+
+typedef struct ac_context ac_context;
+
+typedef struct {
+    int mode;                   // AC_MODE_FLOW, _MAP, _IFS or _BIFURCATION
+    int num_particles;
+    int width, height;          // Output frame size in pixels (>= 16)
+    int start_type;             // Starting attractor/map type (wrapped to the mode's range)
+    int frames_per_fragment;    // Schedule unit: types switch every 6 fragments
+    unsigned int seed;          // Placement and scene decision seed; 0 = current time (unrepeatable)
+    const char *chapter_log;    // Chapter log path, or NULL for none
+    const char *volume_prefix;  // Density volume export prefix, or NULL
+    const char *ply_prefix;     // Point cloud export prefix, or NULL
+    int proxy;                  // 1 = preview proxy (flow mode): simulates 1 in 20 particles,
+                                // renders at half width and height and upscales to width x height
+    int physics_interval;       // Flow mode physics every k-th frame (1-4); -1 = physics_interval key
+    int temporal_frames;        // Temporal history length (0 = off, max 64); -1 = temporal_frames key
+} ac_options;
+
+typedef struct {
+    int frame;                  // Frames stepped so far
+    int current_type, previous_type;
+    float transition_blend;     // 1.0 = fully current type
+    float cam_scale, cam_cx, cam_cy;
+    int noise_metric;           // noise_metric=1: the noise fields below are measured
+    float noise;                // Last rendered frame's high-pass RMS (8-bit luma)
+    double mean_noise;          // Mean over rendered frames
+    int frames_rendered;
+    int num_particles;          // Effective count (bifurcation rounds to whole columns)
+    int width, height;
+    int volumes_written, clouds_written;
+} ac_stats;
+
+// Host views of a context's buffers. The pointers stay valid for the life
+// of the context; ac_sync_host refreshes them from the device.
+typedef struct {
+    float *x, *y, *z;           // Particle positions (as drawn)
+    float *vx, *vy, *vz;        // Particle velocities
+    float *speed;               // |v| per particle, computed by ac_sync_host (NULL if out of memory)
+    float *accum;               // accum_width*accum_height*3 linear radiance of the last render (before denoise)
+    unsigned char *frame;       // width*height*3 RGB24 of the last render
+    int num_particles, width, height;
+    int accum_width, accum_height;  // Render size; smaller than the frame in proxy mode
+} ac_buffers;
+
+void ac_default_options(ac_options *opt);
+
+// Mode index for a -m style name ("flow", "map", ...), or -1
+int ac_mode_from_name(const char *name);
+
+// Process-wide configuration, same keys as the config file.
+// ac_configure returns 0 if the key was recognized, -1 otherwise.
+void ac_load_config(const char *path);
+int ac_configure(const char *key, const char *value);
+
+// Hot reload: re-read a config file between ac_step calls and apply the keys
+// a running context can change in place (framing multipliers, zoom, denoise
+// and temporal tuning, ...), all at once. Out-of-range values and keys that
+// need a restart are reported on stderr and ignored; particle state is kept.
+// Returns the number of keys changed, or -1 if the file cannot be read.
+int ac_reload_config(ac_context *ctx, const char *path);
+
+// NULL on invalid options or allocation failure (reason on stderr). With
+// auto_calibrate=1 a flow context re-measures the process-wide framing
+// multipliers first, which counts as a config change for other threads.
+ac_context *ac_create(const ac_options *opt);
+void ac_destroy(ac_context *ctx);
+
+// Advance the schedule, physics and camera by one frame, and run any exports
+// due on it. Render at most once per step; temporal accumulation assumes one.
+void ac_step(ac_context *ctx);
+
+// Render the current state and tone map it into rgb (width*height*3 bytes,
+// row-major RGB24). rgb may be NULL to leave the frame only in the context.
+void ac_render(ac_context *ctx, unsigned char *rgb);
+
+void ac_get_stats(const ac_context *ctx, ac_stats *stats);
+
+void ac_get_buffers(ac_context *ctx, ac_buffers *buf);
+
+// Download particles, speed and the accum buffer to the host views (the frame
+// is always downloaded by ac_render). ac_sync_device uploads edited
+// positions and velocities back before the next step.
+void ac_sync_host(ac_context *ctx);
+void ac_sync_device(ac_context *ctx);
+
+// Snapshot a point cloud at the next step (needs ply_prefix)
+void ac_request_point_cloud(ac_context *ctx);
+
+// Write out a partially accumulated volume and wait for queued exports
+void ac_flush(ac_context *ctx);
+
+// Live control. Queues one command line to be applied at the start of the
+// next ac_step; the one call that may come from another thread while the
+// context runs (one such thread at a time). Never blocks: returns -1 if 64
+// commands are already waiting. Commands:
+//   type <n|name>      switch attractor/map type (single-scene flow, map)
+//   param <a-f> <v>    set a parameter target; eased in like a type switch (not scenes, IFS)
+//   pan <dx> <dy>      offset the camera target, in frame heights (adds up)
+//   zoom <f>           multiply the camera's target zoom (adds up)
+//   exposure <f>       tone map exposure multiplier (1 = default)
+//   reset              clear pan, zoom and exposure
+//   pause / resume     freeze the scene; ac_render repeats the last frame
+//   seek <frame>       move the schedule clock to that frame
+// Applied and rejected commands are reported on stderr.
+int ac_post_command(ac_context *ctx, const char *line);
+
+// Single-shot modes that stream their result to stdout
+int ac_run_lyapunov(int type, int width, int height);
+int ac_run_calibration(void);
+
+// Long-exposure still of a flow scene (opt->mode and opt->proxy are ignored).
+// The final image goes to stdout as a PPM; progressive previews are written
+// to preview_path (replaced atomically) if it is not NULL.
+int ac_run_still(const ac_options *opt, const char *preview_path);
+
+// The same still at any size, rendered in still_tile tiles and streamed to a
+// tiled TIFF at tiff_path (BigTIFF past 4 GB). Needs still_steps.
+int ac_run_still_tiled(const ac_options *opt, const char *tiff_path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif